@@ -0,0 +1,325 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "rng.h"
+
+/*
+  ChaCha20 (RFC 8439: 256 bit key, 96 bit nonce, 32 bit block counter).
+
+  the quarter round is written once as a template and used both on plain words (one block)
+  and on gcc vector types, where lane l of every word vector is block counter + l: 8 blocks
+  per step with avx2, 16 with avx512f. the vector path is always inlined into the target
+  specific entry points and the rotates are spelled out, so no vector goes through the
+  default abi (same approach as sha256_mb.h).
+*/
+
+namespace blue_crypto
+{
+
+static constexpr std::size_t chacha20_key_size   = 32;
+static constexpr std::size_t chacha20_nonce_size = 12;
+static constexpr std::size_t chacha20_block_size = 64;
+
+namespace detail
+{
+
+template <std::size_t W>
+struct chacha20_vec;
+
+template <>
+struct chacha20_vec<8>
+{
+  using type = std::uint32_t __attribute__((vector_size(32)));
+};
+
+template <>
+struct chacha20_vec<16>
+{
+  using type = std::uint32_t __attribute__((vector_size(64)));
+};
+
+inline std::uint32_t
+load_le32(const std::byte* _p) noexcept
+{
+  std::uint32_t v;
+  std::memcpy(&v, _p, 4);
+  return v;
+}
+
+inline void
+store_le32(std::byte* _p, std::uint32_t _v) noexcept
+{
+  std::memcpy(_p, &_v, 4);
+}
+
+template <class V>
+[[gnu::always_inline]] inline void
+chacha20_quarter(V& _a, V& _b, V& _c, V& _d) noexcept
+{
+  _a += _b;
+  _d ^= _a;
+  _d = _d << 16 | _d >> 16;
+  _c += _d;
+  _b ^= _c;
+  _b = _b << 12 | _b >> 20;
+  _a += _b;
+  _d ^= _a;
+  _d = _d << 8 | _d >> 24;
+  _c += _d;
+  _b ^= _c;
+  _b = _b << 7 | _b >> 25;
+}
+
+/* the 20 rounds on the 16 state words, V is a word or a vector of words */
+template <class V>
+[[gnu::always_inline]] inline void
+chacha20_rounds(V (&_x)[16]) noexcept
+{
+  for (int i = 0; i != 10; ++i)
+  {
+    chacha20_quarter(_x[0], _x[4], _x[8], _x[12]);
+    chacha20_quarter(_x[1], _x[5], _x[9], _x[13]);
+    chacha20_quarter(_x[2], _x[6], _x[10], _x[14]);
+    chacha20_quarter(_x[3], _x[7], _x[11], _x[15]);
+    chacha20_quarter(_x[0], _x[5], _x[10], _x[15]);
+    chacha20_quarter(_x[1], _x[6], _x[11], _x[12]);
+    chacha20_quarter(_x[2], _x[7], _x[8], _x[13]);
+    chacha20_quarter(_x[3], _x[4], _x[9], _x[14]);
+  }
+}
+
+/* one 64 byte block for the counter in _state[12] */
+inline void
+chacha20_block(const std::uint32_t* _state, std::byte* _out) noexcept
+{
+  std::uint32_t x[16];
+  std::copy_n(_state, 16, x);
+  chacha20_rounds(x);
+
+  for (std::size_t j = 0; j != 16; ++j)
+  {
+    store_le32(_out + 4 * j, x[j] + _state[j]);
+  }
+}
+
+/* W blocks for the counters _state[12] .. _state[12] + W - 1 */
+template <std::size_t W>
+[[gnu::always_inline]] inline void
+chacha20_blocks_lanes(const std::uint32_t* _state, std::byte* _out) noexcept
+{
+  using V = typename chacha20_vec<W>::type;
+
+  V lane;
+  for (std::size_t l = 0; l != W; ++l)
+  {
+    lane[l] = static_cast<std::uint32_t>(l);
+  }
+
+  V in[16], x[16];
+  for (std::size_t j = 0; j != 16; ++j)
+  {
+    in[j] = V{} + _state[j];
+  }
+  in[12] += lane;
+  std::copy_n(in, 16, x);
+
+  chacha20_rounds(x);
+
+  for (std::size_t j = 0; j != 16; ++j)
+  {
+    x[j] += in[j];
+    for (std::size_t l = 0; l != W; ++l)
+    {
+      store_le32(_out + 64 * l + 4 * j, x[j][l]);
+    }
+  }
+}
+
+#if defined(__x86_64__)
+
+[[gnu::target("avx2")]] inline void
+chacha20_blocks_avx2(const std::uint32_t* _state, std::byte* _out) noexcept
+{
+  chacha20_blocks_lanes<8>(_state, _out);
+}
+
+[[gnu::target("avx512f")]] inline void
+chacha20_blocks_avx512(const std::uint32_t* _state, std::byte* _out) noexcept
+{
+  chacha20_blocks_lanes<16>(_state, _out);
+}
+
+#endif
+
+struct chacha20_kernels
+{
+  std::size_t width;
+  const char* name;
+};
+
+inline chacha20_kernels
+select_chacha20_kernels() noexcept
+{
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+  {
+    return {16, "avx512 16 blocks"};
+  }
+  if (__builtin_cpu_supports("avx2"))
+  {
+    return {8, "avx2 8 blocks"};
+  }
+#endif
+  return {1, "scalar"};
+}
+
+} // namespace detail
+
+/* resolved once during static init, like fe_kernel */
+inline const detail::chacha20_kernels chacha20_kernel = detail::select_chacha20_kernels();
+
+namespace detail
+{
+
+/* _blocks blocks of key stream from the counter in _state[12], which is advanced past them */
+inline void
+chacha20_keystream(std::uint32_t* _state, std::byte* _out, std::size_t _blocks) noexcept
+{
+#if defined(__x86_64__)
+  const std::size_t width = chacha20_kernel.width;
+  for (; width != 1 && _blocks >= width; _blocks -= width)
+  {
+    if (width == 16)
+    {
+      chacha20_blocks_avx512(_state, _out);
+    }
+    else
+    {
+      chacha20_blocks_avx2(_state, _out);
+    }
+    _state[12] += static_cast<std::uint32_t>(width);
+    _out += width * chacha20_block_size;
+  }
+#endif
+  for (; _blocks != 0; --_blocks)
+  {
+    chacha20_block(_state, _out);
+    ++_state[12];
+    _out += chacha20_block_size;
+  }
+}
+
+} // namespace detail
+
+/*
+  a ChaCha20 stream: keystream() and apply() continue where the previous call stopped, so
+  a message can be fed in chunks of any size. whole blocks go through the lane kernels
+  straight into the output, only a partial block at either end is buffered.
+*/
+class chacha20
+{
+public:
+  chacha20(std::span<const std::byte, chacha20_key_size> _key, std::span<const std::byte, chacha20_nonce_size> _nonce,
+           std::uint32_t _counter = 0) noexcept
+  {
+    // "expand 32-byte k"
+    state_[0] = 0x61707865;
+    state_[1] = 0x3320646e;
+    state_[2] = 0x79622d32;
+    state_[3] = 0x6b206574;
+    for (std::size_t i = 0; i != 8; ++i)
+    {
+      state_[4 + i] = detail::load_le32(_key.data() + 4 * i);
+    }
+    state_[12] = _counter;
+    for (std::size_t i = 0; i != 3; ++i)
+    {
+      state_[13 + i] = detail::load_le32(_nonce.data() + 4 * i);
+    }
+  }
+
+  chacha20(const chacha20&)            = delete;
+  chacha20& operator=(const chacha20&) = delete;
+
+  ~chacha20()
+  {
+    secure_wipe(state_, sizeof(state_));
+    secure_wipe(buf_, sizeof(buf_));
+  }
+
+  /* raw key stream into _out */
+  void
+  keystream(std::span<std::byte> _out) noexcept
+  {
+    const std::size_t head = std::min(_out.size(), sizeof(buf_) - pos_);
+    std::copy_n(buf_ + pos_, head, _out.data());
+    pos_ += head;
+    _out = _out.subspan(head);
+
+    const std::size_t blocks = _out.size() / chacha20_block_size;
+    detail::chacha20_keystream(state_, _out.data(), blocks);
+    _out = _out.subspan(blocks * chacha20_block_size);
+
+    if (!_out.empty())
+    {
+      detail::chacha20_keystream(state_, buf_, 1);
+      std::copy_n(buf_, _out.size(), _out.data());
+      pos_ = _out.size();
+    }
+  }
+
+  /* _out = _in ^ key stream, _in and _out may be the same buffer */
+  void
+  apply(std::span<const std::byte> _in, std::span<std::byte> _out) noexcept
+  {
+    assert(_in.size() == _out.size());
+
+    const auto xor_into = [&](const std::byte* _ks, std::size_t _n)
+    {
+      for (std::size_t i = 0; i != _n; ++i)
+      {
+        _out[i] = _in[i] ^ _ks[i];
+      }
+      _in  = _in.subspan(_n);
+      _out = _out.subspan(_n);
+    };
+
+    // what is left of the buffered block first, so the rest starts on a block boundary and
+    // goes through the lane kernels in whole steps
+    const std::size_t head = std::min(_in.size(), sizeof(buf_) - pos_);
+    xor_into(buf_ + pos_, head);
+    pos_ += head;
+
+    std::byte ks[16 * chacha20_block_size];
+    std::size_t used = 0;
+    while (_in.size() >= chacha20_block_size)
+    {
+      const std::size_t blocks = std::min(_in.size() / chacha20_block_size, std::size_t{16});
+      detail::chacha20_keystream(state_, ks, blocks);
+      used = std::max(used, blocks * chacha20_block_size);
+      xor_into(ks, blocks * chacha20_block_size);
+    }
+    secure_wipe(ks, used);
+
+    if (!_in.empty())
+    {
+      detail::chacha20_keystream(state_, buf_, 1);
+      pos_ = _in.size();
+      xor_into(buf_, _in.size());
+    }
+  }
+
+private:
+  std::uint32_t state_[16];
+  std::byte buf_[chacha20_block_size];
+  std::size_t pos_ = chacha20_block_size;
+};
+
+} // namespace blue_crypto
@@ -0,0 +1,333 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "chacha20.h"
+#include "field.h"
+#include "rng.h"
+
+/*
+  Poly1305 and the ChaCha20-Poly1305 AEAD of RFC 8439.
+
+  poly1305 keeps the accumulator in three 44 / 44 / 42 bit limbs so a block is nine 64x64
+  multiplies into 128 bits (the "donna 64" layout). the AEAD is a streaming object: the
+  associated data goes in at construction, encrypt() / decrypt() can be called on chunks of
+  any size, finalize() / verify() close the message.
+*/
+
+namespace blue_crypto
+{
+
+static constexpr std::size_t poly1305_tag_size = 16;
+
+using poly1305_tag = std::array<std::byte, poly1305_tag_size>;
+
+class poly1305
+{
+public:
+  explicit poly1305(std::span<const std::byte, 32> _key) noexcept
+  {
+    std::uint64_t t0, t1;
+    std::memcpy(&t0, _key.data(), 8);
+    std::memcpy(&t1, _key.data() + 8, 8);
+
+    // clamped r
+    r_[0] = t0 & 0xffc0fffffff;
+    r_[1] = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffff;
+    r_[2] = (t1 >> 24) & 0x00ffffffc0f;
+
+    std::memcpy(&pad_[0], _key.data() + 16, 8);
+    std::memcpy(&pad_[1], _key.data() + 24, 8);
+  }
+
+  poly1305(const poly1305&)            = delete;
+  poly1305& operator=(const poly1305&) = delete;
+
+  ~poly1305()
+  {
+    secure_wipe(r_, sizeof(r_));
+    secure_wipe(pad_, sizeof(pad_));
+    secure_wipe(h_, sizeof(h_));
+    secure_wipe(buf_, sizeof(buf_));
+  }
+
+  poly1305&
+  update(std::span<const std::byte> _data) noexcept
+  {
+    if (len_ != 0)
+    {
+      const std::size_t n = std::min(_data.size(), sizeof(buf_) - len_);
+      std::copy_n(_data.data(), n, buf_ + len_);
+      len_ += n;
+      _data = _data.subspan(n);
+
+      if (len_ != sizeof(buf_))
+      {
+        return *this;
+      }
+      blocks(buf_, 1, hibit);
+      len_ = 0;
+    }
+
+    const std::size_t full = _data.size() / 16;
+    blocks(_data.data(), full, hibit);
+    _data = _data.subspan(full * 16);
+
+    std::copy_n(_data.data(), _data.size(), buf_);
+    len_ = _data.size();
+    return *this;
+  }
+
+  /* zeros up to the next multiple of 16 bytes, the AEAD pads both of its inputs this way */
+  poly1305&
+  pad16() noexcept
+  {
+    static constexpr std::byte zeros[16]{};
+    return update({zeros, len_ == 0 ? 0 : 16 - len_});
+  }
+
+  poly1305_tag
+  finalize() noexcept
+  {
+    if (len_ != 0)
+    {
+      // the final partial block gets its 1 byte inside the 16 instead of as bit 128
+      buf_[len_] = std::byte{1};
+      std::fill(buf_ + len_ + 1, buf_ + sizeof(buf_), std::byte{0});
+      blocks(buf_, 1, 0);
+    }
+
+    std::uint64_t h0 = h_[0], h1 = h_[1], h2 = h_[2];
+
+    // fully carry h
+    std::uint64_t c = h1 >> 44;
+    h1 &= mask44;
+    h2 += c;
+    c = h2 >> 42;
+    h2 &= mask42;
+    h0 += c * 5;
+    c = h0 >> 44;
+    h0 &= mask44;
+    h1 += c;
+    c = h1 >> 44;
+    h1 &= mask44;
+    h2 += c;
+    c = h2 >> 42;
+    h2 &= mask42;
+    h0 += c * 5;
+    c = h0 >> 44;
+    h0 &= mask44;
+    h1 += c;
+
+    // h - p = h + 5 - 2^130, taken if that doesn't go negative
+    std::uint64_t g0 = h0 + 5;
+    c                = g0 >> 44;
+    g0 &= mask44;
+    std::uint64_t g1 = h1 + c;
+    c                = g1 >> 44;
+    g1 &= mask44;
+    std::uint64_t g2 = h2 + c - (std::uint64_t{1} << 42);
+
+    const std::uint64_t take_g = (g2 >> 63) - 1;
+    h0                         = (h0 & ~take_g) | (g0 & take_g);
+    h1                         = (h1 & ~take_g) | (g1 & take_g);
+    h2                         = (h2 & ~take_g) | (g2 & take_g);
+
+    // + s mod 2^128
+    h0 += pad_[0] & mask44;
+    c = h0 >> 44;
+    h0 &= mask44;
+    h1 += (((pad_[0] >> 44) | (pad_[1] << 20)) & mask44) + c;
+    c = h1 >> 44;
+    h1 &= mask44;
+    h2 += ((pad_[1] >> 24) & mask42) + c;
+
+    const std::uint64_t lo = h0 | (h1 << 44);
+    const std::uint64_t hi = (h1 >> 20) | (h2 << 24);
+
+    poly1305_tag tag;
+    std::memcpy(tag.data(), &lo, 8);
+    std::memcpy(tag.data() + 8, &hi, 8);
+    return tag;
+  }
+
+  static poly1305_tag
+  mac(std::span<const std::byte, 32> _key, std::span<const std::byte> _data) noexcept
+  {
+    return poly1305{_key}.update(_data).finalize();
+  }
+
+private:
+  static constexpr std::uint64_t mask44 = 0xfffffffffff;
+  static constexpr std::uint64_t mask42 = 0x3ffffffffff;
+  static constexpr std::uint64_t hibit  = std::uint64_t{1} << 40;
+
+  void
+  blocks(const std::byte* _in, std::size_t _n, std::uint64_t _hibit) noexcept
+  {
+    const std::uint64_t r0 = r_[0], r1 = r_[1], r2 = r_[2];
+    const std::uint64_t s1 = r1 * (5 << 2), s2 = r2 * (5 << 2);
+
+    std::uint64_t h0 = h_[0], h1 = h_[1], h2 = h_[2];
+    for (; _n != 0; --_n, _in += 16)
+    {
+      std::uint64_t t0, t1;
+      std::memcpy(&t0, _in, 8);
+      std::memcpy(&t1, _in + 8, 8);
+
+      h0 += t0 & mask44;
+      h1 += ((t0 >> 44) | (t1 << 20)) & mask44;
+      h2 += ((t1 >> 24) & mask42) | _hibit;
+
+      const u128 d0 = u128{h0} * r0 + u128{h1} * s2 + u128{h2} * s1;
+      u128 d1       = u128{h0} * r1 + u128{h1} * r0 + u128{h2} * s2;
+      u128 d2       = u128{h0} * r2 + u128{h1} * r1 + u128{h2} * r0;
+
+      std::uint64_t c = static_cast<std::uint64_t>(d0 >> 44);
+      h0              = static_cast<std::uint64_t>(d0) & mask44;
+      d1 += c;
+      c  = static_cast<std::uint64_t>(d1 >> 44);
+      h1 = static_cast<std::uint64_t>(d1) & mask44;
+      d2 += c;
+      c  = static_cast<std::uint64_t>(d2 >> 42);
+      h2 = static_cast<std::uint64_t>(d2) & mask42;
+      h0 += c * 5;
+      c = h0 >> 44;
+      h0 &= mask44;
+      h1 += c;
+    }
+    h_[0] = h0;
+    h_[1] = h1;
+    h_[2] = h2;
+  }
+
+  std::uint64_t r_[3];
+  std::uint64_t pad_[2];
+  std::uint64_t h_[3] = {};
+  std::byte buf_[16];
+  std::size_t len_ = 0;
+};
+
+/*
+  one ChaCha20-Poly1305 message. the one time poly1305 key is key stream block 0, the
+  payload uses the blocks from 1 on. decrypt() hands out plaintext before the tag has been
+  checked: a streaming caller must not act on it until verify() returned true
+*/
+class chacha20_poly1305
+{
+public:
+  chacha20_poly1305(std::span<const std::byte, chacha20_key_size> _key, std::span<const std::byte, chacha20_nonce_size> _nonce,
+                    std::span<const std::byte> _aad = {}) noexcept
+      : cipher_(_key, _nonce), mac_(one_time_key(cipher_).k), aad_len_(_aad.size())
+  {
+    mac_.update(_aad).pad16();
+  }
+
+  chacha20_poly1305(const chacha20_poly1305&)            = delete;
+  chacha20_poly1305& operator=(const chacha20_poly1305&) = delete;
+
+  /* _in and _out may be the same buffer */
+  void
+  encrypt(std::span<const std::byte> _in, std::span<std::byte> _out) noexcept
+  {
+    cipher_.apply(_in, _out);
+    mac_.update(_out);
+    text_len_ += _in.size();
+  }
+
+  void
+  decrypt(std::span<const std::byte> _in, std::span<std::byte> _out) noexcept
+  {
+    mac_.update(_in);
+    cipher_.apply(_in, _out);
+    text_len_ += _in.size();
+  }
+
+  /* the tag over everything encrypted / decrypted so far, ends the message */
+  poly1305_tag
+  finalize() noexcept
+  {
+    std::byte lengths[16];
+    const std::uint64_t aad = aad_len_, text = text_len_;
+    std::memcpy(lengths, &aad, 8);
+    std::memcpy(lengths + 8, &text, 8);
+    return mac_.pad16().update(lengths).finalize();
+  }
+
+  /* finalize() compared to _tag in constant time */
+  bool
+  verify(std::span<const std::byte, poly1305_tag_size> _tag) noexcept
+  {
+    const poly1305_tag tag = finalize();
+
+    std::uint8_t diff = 0;
+    for (std::size_t i = 0; i != poly1305_tag_size; ++i)
+    {
+      diff |= std::to_integer<std::uint8_t>(tag[i] ^ _tag[i]);
+    }
+    return diff == 0;
+  }
+
+  /* whole message in one go, _ct is _pt.size() bytes followed by the tag */
+  static void
+  seal(std::span<const std::byte, chacha20_key_size> _key, std::span<const std::byte, chacha20_nonce_size> _nonce,
+       std::span<const std::byte> _aad, std::span<const std::byte> _pt, std::span<std::byte> _ct) noexcept
+  {
+    assert(_ct.size() == _pt.size() + poly1305_tag_size);
+
+    chacha20_poly1305 aead{_key, _nonce, _aad};
+    aead.encrypt(_pt, _ct.first(_pt.size()));
+    const poly1305_tag tag = aead.finalize();
+    std::copy(tag.begin(), tag.end(), _ct.last<poly1305_tag_size>().begin());
+  }
+
+  /* false (and _pt wiped) if the tag doesn't match */
+  static bool
+  open(std::span<const std::byte, chacha20_key_size> _key, std::span<const std::byte, chacha20_nonce_size> _nonce,
+       std::span<const std::byte> _aad, std::span<const std::byte> _ct, std::span<std::byte> _pt) noexcept
+  {
+    assert(_ct.size() == _pt.size() + poly1305_tag_size);
+
+    chacha20_poly1305 aead{_key, _nonce, _aad};
+    aead.decrypt(_ct.first(_pt.size()), _pt);
+    if (!aead.verify(_ct.last<poly1305_tag_size>()))
+    {
+      secure_wipe(_pt.data(), _pt.size());
+      return false;
+    }
+    return true;
+  }
+
+private:
+  struct otk
+  {
+    std::array<std::byte, 32> k;
+    ~otk() { secure_wipe(k.data(), k.size()); }
+  };
+
+  /* key stream block 0, the first half of it keys poly1305 */
+  static otk
+  one_time_key(chacha20& _cipher) noexcept
+  {
+    std::byte block[chacha20_block_size];
+    _cipher.keystream(block);
+
+    otk out;
+    std::copy_n(block, 32, out.k.data());
+    secure_wipe(block, sizeof(block));
+    return out;
+  }
+
+  chacha20 cipher_;
+  poly1305 mac_;
+  std::uint64_t aad_len_;
+  std::uint64_t text_len_ = 0;
+};
+
+} // namespace blue_crypto
@@ -3,9 +3,15 @@
 #include "gmpxx.h"
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <span>
+#include <vector>
+
+#include "rng.h"
 
 // TODO: possible performance improvements can be done in this file
 
@@ -174,6 +180,129 @@ public:
     return static_cast<size_t>(mpz_sizeinbase(value_, 2));
   }
 
+  // little endian 64 bit limbs, only the magnitude, zero padded up to _count
+  void
+  to_limbs(std::uint64_t* _out, std::size_t _count) const
+  {
+    assert(mpz_sizeinbase(value_, 2) <= _count * 64);
+
+    std::size_t written = 0;
+    mpz_export(_out, &written, -1, sizeof(std::uint64_t), 0, 0, value_);
+    std::fill(_out + written, _out + _count, 0);
+  }
+
+  static GmpWrapper
+  from_limbs(const std::uint64_t* _limbs, std::size_t _count)
+  {
+    GmpWrapper result;
+    mpz_import(result.value_, _count, -1, sizeof(std::uint64_t), 0, 0, _limbs);
+    return result;
+  }
+
+  /*
+    unsigned integer from raw bytes, most significant first for std::endian::big. goes straight
+    through mpz_import, no intermediate string
+  */
+  static GmpWrapper
+  from_bytes(std::span<const std::byte> _in, std::endian _order = std::endian::big)
+  {
+    GmpWrapper result;
+    mpz_import(result.value_, _in.size(), _order == std::endian::big ? 1 : -1, 1, 0, 0, _in.data());
+    return result;
+  }
+
+  /*
+    uniform in [0, _bound) for _bound > 0: draws of bitlength(_bound) bits until one is below
+    the bound, so fewer than two draws on average. _rng is anything with fill(std::span<std::byte>),
+    chacha_drbg::local() for bulk use
+  */
+  template <class Rng>
+  static GmpWrapper
+  random_below(const GmpWrapper& _bound, Rng& _rng)
+  {
+    assert(mpz_sgn(_bound.value_) > 0);
+
+    const std::size_t bits = _bound.bitlength();
+    std::vector<std::byte> buf((bits + 7) / 8);
+
+    GmpWrapper result;
+    do
+    {
+      _rng.fill(buf);
+      buf[0] &= std::byte(0xff >> (8 * buf.size() - bits));
+      mpz_import(result.value_, buf.size(), 1, 1, 0, 0, buf.data());
+    } while (mpz_cmp(result.value_, _bound.value_) >= 0);
+
+    secure_wipe(buf.data(), buf.size());
+    return result;
+  }
+
+  /*
+    zeroes every allocated limb and leaves the value at 0, for secrets that are about to be
+    dropped (mpz_clear frees the limbs without touching them)
+  */
+  void
+  wipe() noexcept
+  {
+    const std::size_t alloc = static_cast<std::size_t>(value_->_mp_alloc);
+    secure_wipe(mpz_limbs_modify(value_, static_cast<mp_size_t>(alloc)), alloc * sizeof(mp_limb_t));
+    mpz_limbs_finish(value_, 0);
+  }
+
+  /*
+    the magnitude as exactly _out.size() bytes, zero padded, read off the limbs directly so
+    nothing is allocated. false (and _out untouched) if it doesn't fit
+  */
+  bool
+  to_bytes(std::span<std::byte> _out, std::endian _order = std::endian::big) const
+  {
+    if ((bitlength() + 7) / 8 > _out.size() && mpz_sgn(value_) != 0)
+    {
+      return false;
+    }
+
+    const mp_limb_t* limbs    = mpz_limbs_read(value_);
+    const std::size_t nlimbs  = mpz_size(value_);
+    constexpr std::size_t per = sizeof(mp_limb_t);
+
+    for (std::size_t i = 0; i != _out.size(); ++i)
+    {
+      const std::size_t limb = i / per;
+      const std::byte b      = limb < nlimbs ? std::byte(limbs[limb] >> (8 * (i % per))) : std::byte{0};
+
+      _out[_order == std::endian::big ? _out.size() - 1 - i : i] = b;
+    }
+    return true;
+  }
+
+  /*
+    the magnitude as exactly _out.size() lowercase hex digits, zero padded, no 0x and no
+    terminator. false (and _out untouched) if it doesn't fit
+  */
+  bool
+  to_hex(std::span<char> _out) const
+  {
+    static constexpr char digits[] = "0123456789abcdef";
+
+    if ((bitlength() + 3) / 4 > _out.size() && mpz_sgn(value_) != 0)
+    {
+      return false;
+    }
+
+    const mp_limb_t* limbs    = mpz_limbs_read(value_);
+    const std::size_t nlimbs  = mpz_size(value_);
+    constexpr std::size_t per = sizeof(mp_limb_t) * 2;
+
+    for (std::size_t i = 0; i != _out.size(); ++i)
+    {
+      const std::size_t limb = i / per;
+      const unsigned nibble  = limb < nlimbs ? (limbs[limb] >> (4 * (i % per))) & 0xf : 0;
+
+      _out[_out.size() - 1 - i] = digits[nibble];
+    }
+    return true;
+  }
+
   void
   write() const
   {
@@ -283,7 +412,10 @@ public:
   friend std::ostream&
   operator<<(std::ostream& os, const GmpWrapper& gmp)
   {
-    return os << mpz_get_str(nullptr, 10, gmp.value_);
+    char* str = mpz_get_str(nullptr, 10, gmp.value_);
+    os << str;
+    free(str);
+    return os;
   }
 
   friend GmpWrapper
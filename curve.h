@@ -0,0 +1,370 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <vector>
+
+#include "crypto.h"
+#include "field.h"
+#include "scalar.h"
+
+/*
+  secp256k1 point code on top of the fixed width field in field.h
+
+  same formulas / table layout as the GmpWrapper version in main.cpp but p is baked in,
+  so nothing here takes a modulus. main.cpp keeps the generic version as the reference.
+*/
+
+namespace blue_crypto::secp256k1
+{
+
+struct crv_p
+{
+  fe x{}, y{};
+
+  void
+  print() const
+  {
+    std::cout << "[";
+    fe_to_ix(x).write();
+    std::cout << ", ";
+    fe_to_ix(y).write();
+    std::cout << "]\n";
+  }
+
+  bool
+  operator==(const crv_p& other) const
+  {
+    return (x == other.x) && (y == other.y);
+  }
+
+  bool
+  operator!=(const crv_p& other) const
+  {
+    return !(this->operator==(other));
+  }
+};
+
+struct jcbn_crv_p
+{
+  fe x{}, y{}, z{};
+
+  void
+  print() const
+  {
+    std::cout << "[";
+    fe_to_ix(x).write();
+    std::cout << ", ";
+    fe_to_ix(y).write();
+    std::cout << ", ";
+    fe_to_ix(z).write();
+    std::cout << "]\n";
+  }
+
+  /* raw coordinate compare, use point_eq for the actual group element */
+  bool
+  operator==(const jcbn_crv_p& other) const
+  {
+    return (x == other.x) && (y == other.y) && (z == other.z);
+  }
+
+  bool
+  operator!=(const jcbn_crv_p& other) const
+  {
+    return !(this->operator==(other));
+  }
+};
+
+static constexpr crv_p a_identity_element      = {fe_zero, fe_zero};
+static constexpr jcbn_crv_p j_identity_element = {fe_one, fe_one, fe_zero};
+
+static constexpr crv_p G = {{{0x59F2815B16F81798ull, 0x029BFCDB2DCE28D9ull, 0x55A06295CE870B07ull, 0x79BE667EF9DCBBACull}},
+                            {{0x9C47D08FFB10D4B8ull, 0xFD17B448A6855419ull, 0x5DA4FBFC0E1108A8ull, 0x483ADA7726A3C465ull}}};
+
+/* group order n, little endian limbs */
+static constexpr std::uint64_t group_order[4] = {0xBFD25E8CD0364141ull, 0xBAAEDCE6AF48A03Bull, 0xFFFFFFFFFFFFFFFEull,
+                                                 0xFFFFFFFFFFFFFFFFull};
+
+[[gnu::pure]] inline bool
+is_identity(const jcbn_crv_p& _p) noexcept
+{
+  return fe_is_zero(_p.z);
+}
+
+inline jcbn_crv_p
+to_jacobian(const crv_p& _ws_point)
+{
+  return {_ws_point.x, _ws_point.y, fe_one};
+}
+
+inline crv_p
+from_jacobian(const jcbn_crv_p& _jcbn)
+{
+  if (is_identity(_jcbn))
+  {
+    return a_identity_element;
+  }
+
+  const fe inv  = fe_inv(_jcbn.z);
+  const fe inv2 = fe_sqr(inv);
+  return {fe_mul(_jcbn.x, inv2), fe_mul(_jcbn.y, fe_mul(inv2, inv))};
+}
+
+/* only X / Z^2, for callers that never look at y. _jcbn must not be O */
+[[gnu::pure]] inline fe
+affine_x(const jcbn_crv_p& _jcbn) noexcept
+{
+  return fe_mul(_jcbn.x, fe_sqr(fe_inv(_jcbn.z)));
+}
+
+static constexpr fe curve_b = {{7, 0, 0, 0}};
+
+/* the point with x coordinate _x and y parity _odd, false if x^3 + 7 isn't a square */
+inline bool
+lift_x(crv_p& _out, const fe& _x, bool _odd) noexcept
+{
+  fe y;
+  if (!fe_sqrt(y, fe_add(fe_mul(fe_sqr(_x), _x), curve_b)))
+  {
+    return false;
+  }
+
+  _out = {_x, ((y.n[0] & 1) != _odd) ? fe_neg(y) : y};
+  return true;
+}
+
+/* sec1 compressed, 0x02 / 0x03 by the parity of y then x, 33 bytes. _p must not be O */
+inline void
+to_compressed(const crv_p& _p, std::byte* _out) noexcept
+{
+  _out[0] = std::byte{static_cast<unsigned char>(0x02 | (_p.y.n[0] & 1))};
+  fe_to_bytes(_p.x, _out + 1);
+}
+
+/* same group element, compared projectively without an inversion */
+[[gnu::pure]] inline bool
+point_eq(const jcbn_crv_p& _p1, const jcbn_crv_p& _p2) noexcept
+{
+  if (is_identity(_p1) || is_identity(_p2))
+  {
+    return is_identity(_p1) && is_identity(_p2);
+  }
+
+  const fe z1z1 = fe_sqr(_p1.z);
+  const fe z2z2 = fe_sqr(_p2.z);
+
+  return fe_mul(_p1.x, z2z2) == fe_mul(_p2.x, z1z1) && fe_mul(_p1.y, fe_mul(z2z2, _p2.z)) == fe_mul(_p2.y, fe_mul(z1z1, _p1.z));
+}
+
+/* from_jacobian for a whole span with one shared inversion, identity maps to a_identity_element */
+inline void
+batch_from_jacobian(std::span<const jcbn_crv_p> _in, std::span<crv_p> _out)
+{
+  assert(_in.size() == _out.size());
+
+  std::vector<fe> inv(_in.size());
+  for (std::size_t i = 0; i != _in.size(); ++i)
+  {
+    inv[i] = _in[i].z;
+  }
+  fe_batch_inv(inv);
+
+  for (std::size_t i = 0; i != _in.size(); ++i)
+  {
+    if (is_identity(_in[i])) [[unlikely]]
+    {
+      _out[i] = a_identity_element;
+      continue;
+    }
+
+    const fe inv2 = fe_sqr(inv[i]);
+    _out[i]       = {fe_mul(_in[i].x, inv2), fe_mul(_in[i].y, fe_mul(inv2, inv[i]))};
+  }
+}
+
+/* dbl-2009-l, a = 0 */
+inline jcbn_crv_p
+point_double(const jcbn_crv_p& _p1)
+{
+  if (fe_is_zero(_p1.y) || is_identity(_p1)) [[unlikely]]
+  {
+    return j_identity_element;
+  }
+
+  const fe a = fe_sqr(_p1.x);
+  const fe b = fe_sqr(_p1.y);
+  const fe c = fe_sqr(b);
+  const fe d = fe_dbl(fe_sub(fe_sub(fe_sqr(fe_add(_p1.x, b)), a), c));
+  const fe e = fe_add(fe_dbl(a), a);
+  const fe f = fe_sqr(e);
+
+  jcbn_crv_p out;
+
+  out.x = fe_sub(f, fe_dbl(d));
+  out.y = fe_sub(fe_mul(e, fe_sub(d, out.x)), fe_mul_small(c, 8));
+  out.z = fe_dbl(fe_mul(_p1.y, _p1.z));
+
+  return out;
+}
+
+inline jcbn_crv_p
+point_add(const jcbn_crv_p& _p1, const jcbn_crv_p& _p2)
+{
+  if (is_identity(_p1))
+  {
+    return _p2;
+  }
+  else if (is_identity(_p2))
+  {
+    return _p1;
+  }
+
+  const fe z1z1 = fe_sqr(_p1.z);
+  const fe z2z2 = fe_sqr(_p2.z);
+  const fe U1   = fe_mul(_p1.x, z2z2);
+  const fe U2   = fe_mul(_p2.x, z1z1);
+  const fe S1   = fe_mul(_p1.y, fe_mul(_p2.z, z2z2));
+  const fe S2   = fe_mul(_p2.y, fe_mul(_p1.z, z1z1));
+
+  if (U1 == U2) [[unlikely]]
+  {
+    if (S1 != S2) [[unlikely]]
+    {
+      return j_identity_element;
+    }
+    else
+    {
+      return point_double(_p1);
+    }
+  }
+
+  const fe H   = fe_sub(U2, U1);
+  const fe R   = fe_sub(S2, S1);
+  const fe HH  = fe_sqr(H);
+  const fe HHH = fe_mul(H, HH);
+  const fe V   = fe_mul(U1, HH);
+
+  jcbn_crv_p out;
+
+  out.x = fe_sub(fe_sub(fe_sqr(R), HHH), fe_dbl(V));
+  out.y = fe_sub(fe_mul(R, fe_sub(V, out.x)), fe_mul(S1, HHH));
+  out.z = fe_mul(fe_mul(_p1.z, _p2.z), H);
+
+  return out;
+}
+
+/* _p1 + _p2 with _p2 affine (z = 1), 8M + 3S instead of 12M + 4S */
+inline jcbn_crv_p
+point_add_mixed(const jcbn_crv_p& _p1, const crv_p& _p2)
+{
+  if (_p2 == a_identity_element)
+  {
+    return _p1;
+  }
+  else if (is_identity(_p1))
+  {
+    return to_jacobian(_p2);
+  }
+
+  const fe z1z1 = fe_sqr(_p1.z);
+  const fe U2   = fe_mul(_p2.x, z1z1);
+  const fe S2   = fe_mul(_p2.y, fe_mul(_p1.z, z1z1));
+
+  if (_p1.x == U2) [[unlikely]]
+  {
+    return (_p1.y == S2) ? point_double(_p1) : j_identity_element;
+  }
+
+  const fe H   = fe_sub(U2, _p1.x);
+  const fe R   = fe_sub(S2, _p1.y);
+  const fe HH  = fe_sqr(H);
+  const fe HHH = fe_mul(H, HH);
+  const fe V   = fe_mul(_p1.x, HH);
+
+  jcbn_crv_p out;
+
+  out.x = fe_sub(fe_sub(fe_sqr(R), HHH), fe_dbl(V));
+  out.y = fe_sub(fe_mul(R, fe_sub(V, out.x)), fe_mul(_p1.y, HHH));
+  out.z = fe_mul(_p1.z, H);
+
+  return out;
+}
+
+static constexpr std::size_t window_size = 4;
+
+/* {O, 1P, 2P, 3P, ..., (2^w-1)P} */
+inline std::vector<jcbn_crv_p>
+precompute(const jcbn_crv_p& Q)
+{
+  const std::size_t count = std::size_t{1} << window_size;
+
+  std::vector<jcbn_crv_p> out;
+  out.reserve(count);
+
+  out.push_back(j_identity_element);
+  out.push_back(Q);
+
+  jcbn_crv_p next{Q};
+
+  for (std::size_t i = 2; i != count; ++i)
+  {
+    next = (i == 2) ? point_double(Q) : point_add(Q, next);
+    out.push_back(next);
+  }
+
+  return out;
+}
+
+inline jcbn_crv_p
+windowed_scalar_mul(const std::vector<jcbn_crv_p>& _precomp, const GmpWrapper& _num)
+{
+  jcbn_crv_p Q{j_identity_element};
+  const std::size_t m = (_num.bitlength() + window_size - 1) / window_size;
+
+  for (std::size_t i = 0; i != m; ++i)
+  {
+    for (auto j = 0ul; j != window_size; ++j)
+    {
+      Q = point_double(Q);
+    }
+
+    const std::size_t start_idx = (m - i - 1) * window_size;
+    const std::size_t nbits     = _num.get_bits(start_idx, window_size);
+
+    if (nbits > 0) [[likely]]
+    {
+      Q = point_add(Q, _precomp[nbits]);
+    }
+  }
+  return Q;
+}
+
+/* same as above but the digits come straight out of the limbs, no mpz bit fiddling per window */
+inline jcbn_crv_p
+windowed_scalar_mul(const std::vector<jcbn_crv_p>& _precomp, const sc& _num)
+{
+  static_assert(window_size == 4, "sc_window hands out 4 bit digits");
+
+  jcbn_crv_p Q{j_identity_element};
+  const std::size_t m = (sc_bitlength(_num) + window_size - 1) / window_size;
+
+  for (std::size_t i = 0; i != m; ++i)
+  {
+    for (auto j = 0ul; j != window_size; ++j)
+    {
+      Q = point_double(Q);
+    }
+
+    const std::size_t nbits = sc_window(_num, m - i - 1);
+
+    if (nbits > 0) [[likely]]
+    {
+      Q = point_add(Q, _precomp[nbits]);
+    }
+  }
+  return Q;
+}
+
+} // namespace blue_crypto::secp256k1
@@ -0,0 +1,654 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "curve.h"
+#include "rng.h"
+
+/*
+  batch scalar mul modes on the scalar field code, no SIMD needed.
+*/
+
+namespace blue_crypto::secp256k1
+{
+
+/* precompute() tables normalized to affine with one inversion for all of them, entry 0 stays O */
+inline std::vector<std::vector<crv_p>>
+to_affine_tables(std::span<const std::vector<jcbn_crv_p>* const> _tables)
+{
+  std::vector<jcbn_crv_p> flat;
+  for (const auto* table : _tables)
+  {
+    flat.insert(flat.end(), table->begin(), table->end());
+  }
+
+  std::vector<crv_p> affine(flat.size());
+  batch_from_jacobian(flat, affine);
+
+  std::vector<std::vector<crv_p>> out;
+  out.reserve(_tables.size());
+
+  auto it = affine.begin();
+  for (const auto* table : _tables)
+  {
+    out.emplace_back(it, it + table->size());
+    it += table->size();
+  }
+  return out;
+}
+
+/*
+  lockstep affine: all muls of a batch do the same doubling / add step together in affine
+  coordinates, and each step shares one fe_inv across the batch (montgomery's trick).
+  per mul that is ~6M per double and ~5M per add instead of 7M / 16M for jacobian, plus one
+  inversion per step split over the batch, so it wins once the batch is large enough.
+*/
+struct affine_lockstep
+{
+  std::vector<crv_p> Q;
+  std::vector<std::uint8_t> live;
+  std::vector<const crv_p*> T; // point to add per lane for the next add_all(), nullptr = none
+  std::vector<std::size_t> idx;
+  std::vector<fe> den, scratch;
+
+  explicit affine_lockstep(std::size_t _n) : Q(_n, a_identity_element), live(_n, 0), T(_n, nullptr), idx(_n), den(_n), scratch(_n) {}
+
+  void
+  double_all()
+  {
+    std::size_t cnt = 0;
+    for (std::size_t l = 0; l != Q.size(); ++l)
+    {
+      if (live[l])
+      {
+        den[cnt]   = fe_dbl(Q[l].y); // never 0, secp256k1 has no points of order 2
+        idx[cnt++] = l;
+      }
+    }
+
+    fe_batch_inv(std::span{den}.first(cnt), scratch);
+
+    for (std::size_t c = 0; c != cnt; ++c)
+    {
+      crv_p& q     = Q[idx[c]];
+      const fe xx  = fe_sqr(q.x);
+      const fe lam = fe_mul(fe_add(fe_dbl(xx), xx), den[c]);
+      const fe x3  = fe_sub(fe_sqr(lam), fe_dbl(q.x));
+      q.y          = fe_sub(fe_mul(lam, fe_sub(q.x, x3)), q.y);
+      q.x          = x3;
+    }
+  }
+
+  /* Q[l] += *T[l] for every lane with T[l] set, clears T */
+  void
+  add_all()
+  {
+    std::size_t cnt = 0;
+    for (std::size_t l = 0; l != Q.size(); ++l)
+    {
+      if (!T[l])
+      {
+        continue;
+      }
+
+      if (!live[l])
+      {
+        Q[l]    = *T[l];
+        live[l] = 1;
+      }
+      else if (Q[l].x == T[l]->x) [[unlikely]]
+      {
+        // P == Q needs the tangent, P == -Q gives O
+        if (Q[l].y == T[l]->y)
+        {
+          Q[l] = from_jacobian(point_double(to_jacobian(Q[l])));
+        }
+        else
+        {
+          Q[l]    = a_identity_element;
+          live[l] = 0;
+        }
+      }
+      else
+      {
+        den[cnt]   = fe_sub(T[l]->x, Q[l].x);
+        idx[cnt++] = l;
+        continue;
+      }
+      T[l] = nullptr;
+    }
+
+    fe_batch_inv(std::span{den}.first(cnt), scratch);
+
+    for (std::size_t c = 0; c != cnt; ++c)
+    {
+      crv_p& q       = Q[idx[c]];
+      const crv_p& t = *T[idx[c]];
+      const fe lam   = fe_mul(fe_sub(t.y, q.y), den[c]);
+      const fe x3    = fe_sub(fe_sub(fe_sqr(lam), q.x), t.x);
+      q.y            = fe_sub(fe_mul(lam, fe_sub(q.x, x3)), q.y);
+      q.x            = x3;
+      T[idx[c]]      = nullptr;
+    }
+  }
+
+  void
+  store(std::span<crv_p> _out) const
+  {
+    for (std::size_t l = 0; l != Q.size(); ++l)
+    {
+      _out[l] = live[l] ? Q[l] : a_identity_element;
+    }
+  }
+};
+
+/* same results as from_jacobian(windowed_scalar_mul(...)) on every entry, tables from to_affine_tables */
+inline void
+batch_windowed_scalar_mul_affine(std::span<const std::vector<crv_p>* const> _tables, std::span<const GmpWrapper> _nums,
+                                 std::span<crv_p> _out)
+{
+  assert(_tables.size() == _nums.size() && _nums.size() == _out.size());
+
+  static constexpr std::size_t windows = 256 / window_size;
+  const std::size_t n                  = _nums.size();
+
+  std::vector<std::array<std::uint64_t, 4>> k(n);
+  for (std::size_t l = 0; l != n; ++l)
+  {
+    _nums[l].to_limbs(k[l].data(), 4);
+  }
+
+  affine_lockstep state(n);
+
+  for (std::size_t i = 0; i != windows; ++i)
+  {
+    for (std::size_t j = 0; j != window_size; ++j)
+    {
+      state.double_all();
+    }
+
+    const std::size_t w = windows - i - 1;
+    for (std::size_t l = 0; l != n; ++l)
+    {
+      const std::size_t digit = (k[l][w / 16] >> ((w % 16) * window_size)) & ((1u << window_size) - 1);
+      if (digit != 0)
+      {
+        state.T[l] = &(*_tables[l])[digit];
+      }
+    }
+    state.add_all();
+  }
+
+  state.store(_out);
+}
+
+/* (d * 16^i)G for window i and digit d in affine, 16 entries per window with entry 0 = O. built once */
+inline const std::vector<crv_p>&
+fixed_base_table()
+{
+  static const std::vector<crv_p> table = []
+  {
+    static constexpr std::size_t windows = 256 / window_size;
+
+    std::vector<jcbn_crv_p> flat;
+    flat.reserve(windows << window_size);
+
+    jcbn_crv_p base = to_jacobian(G);
+    for (std::size_t i = 0; i != windows; ++i)
+    {
+      const auto multiples = precompute(base);
+      flat.insert(flat.end(), multiples.begin(), multiples.end());
+
+      for (std::size_t j = 0; j != window_size; ++j)
+      {
+        base = point_double(base);
+      }
+    }
+
+    std::vector<crv_p> out(flat.size());
+    batch_from_jacobian(flat, out);
+    return out;
+  }();
+
+  return table;
+}
+
+/* homogeneous projective, x = X/Z and y = Y/Z, O = (0 : 1 : 0). only the constant time muls use it */
+struct proj_crv_p
+{
+  fe x{}, y{}, z{};
+};
+
+/*
+  _p + _q, complete for a = 0 (renes, costello, batina 2016, algorithm 8): right for every _p
+  including O, _p == _q and _p == -_q, with _q affine and not O. 11 mul + 2 small mul and not a
+  single branch, whatever the inputs
+*/
+inline proj_crv_p
+point_add_complete(const proj_crv_p& _p, const crv_p& _q) noexcept
+{
+  // 3b, b = 7
+  static constexpr std::uint32_t b3 = 21;
+
+  fe t0 = fe_mul(_p.x, _q.x);
+  fe t1 = fe_mul(_p.y, _q.y);
+  fe t3 = fe_sub(fe_mul(fe_add(_q.x, _q.y), fe_add(_p.x, _p.y)), fe_add(t0, t1));
+  fe t4 = fe_add(fe_mul(_q.y, _p.z), _p.y);
+  fe y3 = fe_add(fe_mul(_q.x, _p.z), _p.x);
+  t0    = fe_add(fe_dbl(t0), t0);
+
+  fe t2 = fe_mul_small(_p.z, b3);
+  fe z3 = fe_add(t1, t2);
+  t1    = fe_sub(t1, t2);
+  y3    = fe_mul_small(y3, b3);
+
+  fe x3 = fe_sub(fe_mul(t3, t1), fe_mul(t4, y3));
+  y3    = fe_add(fe_mul(t1, z3), fe_mul(y3, t0));
+  z3    = fe_add(fe_mul(z3, t4), fe_mul(t0, t3));
+  return {x3, y3, z3};
+}
+
+/* 2 _p, complete for a = 0 (same paper, algorithm 9): 6 mul + 2 sqr, O stays O */
+inline proj_crv_p
+point_double_complete(const proj_crv_p& _p) noexcept
+{
+  static constexpr std::uint32_t b3 = 21;
+
+  fe t0 = fe_sqr(_p.y);
+  fe z3 = fe_dbl(fe_dbl(fe_dbl(t0)));
+  fe t1 = fe_mul(_p.y, _p.z);
+  fe t2 = fe_mul_small(fe_sqr(_p.z), b3);
+  fe x3 = fe_mul(t2, z3);
+  fe y3 = fe_add(t0, t2);
+  z3    = fe_mul(t1, z3);
+  t2    = fe_add(fe_dbl(t2), t2);
+  t0    = fe_sub(t0, t2);
+  y3    = fe_add(x3, fe_mul(t0, y3));
+  x3    = fe_dbl(fe_mul(t0, fe_mul(_p.x, _p.y)));
+  return {x3, y3, z3};
+}
+
+/* (X : Y : Z) is (X Z, Y Z^2, Z) in jacobian, Z = 0 (O) is blended to j_identity_element */
+inline jcbn_crv_p
+proj_to_jacobian(const proj_crv_p& _p) noexcept
+{
+  jcbn_crv_p out{fe_mul(_p.x, _p.z), fe_mul(_p.y, fe_sqr(_p.z)), _p.z};
+  const std::uint64_t inf = fe_is_zero(_p.z);
+  fe_cmov(out.x, j_identity_element.x, inf);
+  fe_cmov(out.y, j_identity_element.y, inf);
+  return out;
+}
+
+/*
+  entry _digit of a 16 entry row, read without indexing by _digit: all 15 nonzero entries are
+  loaded and the match kept with a masked select. entry 0 is O, which no mixed add takes, so
+  digit 0 gets entry 1 and the caller drops that sum
+*/
+inline crv_p
+table_select(const crv_p* _row, std::uint64_t _digit) noexcept
+{
+  crv_p T = _row[1];
+  for (std::uint64_t j = 2; j != (1u << window_size); ++j)
+  {
+    const std::uint64_t hit = ((_digit ^ j) - 1) >> 63;
+    fe_cmov(T.x, _row[j].x, hit);
+    fe_cmov(T.y, _row[j].y, hit);
+  }
+  return T;
+}
+
+inline std::uint64_t
+fixed_base_digit(const std::array<std::uint64_t, 4>& _k, std::size_t _w) noexcept
+{
+  return (_k[_w / 16] >> ((_w % 16) * window_size)) & ((1u << window_size) - 1);
+}
+
+/* entry _digit of window _w through table_select */
+inline crv_p
+fixed_base_select(const std::vector<crv_p>& _table, std::size_t _w, std::uint64_t _digit) noexcept
+{
+  return table_select(&_table[_w << window_size], _digit);
+}
+
+/*
+  k*G off the fixed base table in jacobian, no doublings. constant time in _k, it is used on
+  private keys and nonces: every window takes its entry through fixed_base_select, the complete
+  add runs for every window and a zero digit just doesn't keep its sum
+*/
+inline jcbn_crv_p
+fixed_base_mul(const std::array<std::uint64_t, 4>& _k)
+{
+  static constexpr std::size_t windows = 256 / window_size;
+  const auto& table                    = fixed_base_table();
+
+  proj_crv_p Q{fe_zero, fe_one, fe_zero};
+  for (std::size_t w = 0; w != windows; ++w)
+  {
+    const std::uint64_t digit = fixed_base_digit(_k, w);
+    const proj_crv_p S        = point_add_complete(Q, fixed_base_select(table, w, digit));
+    const std::uint64_t keep = (0 - digit) >> 63;
+    fe_cmov(Q.x, S.x, keep);
+    fe_cmov(Q.y, S.y, keep);
+    fe_cmov(Q.z, S.z, keep);
+  }
+
+  // Z = 0 only for k = 0
+  return proj_to_jacobian(Q);
+}
+
+inline jcbn_crv_p
+fixed_base_mul(const sc& _k)
+{
+  return fixed_base_mul(std::array<std::uint64_t, 4>{_k.n[0], _k.n[1], _k.n[2], _k.n[3]});
+}
+
+/*
+  _digit(w) (w = 63 is the top window) times the point of the affine 16 entry row _row (entry 1
+  not O), constant time in the digits: all 64 windows do four complete doublings and one
+  complete add of the table_select entry, a zero digit drops the sum like in fixed_base_mul
+*/
+template <class Digit>
+inline jcbn_crv_p
+row_scalar_mul_ct(const crv_p* _row, Digit&& _digit)
+{
+  static constexpr std::size_t windows = 256 / window_size;
+
+  proj_crv_p Q{fe_zero, fe_one, fe_zero};
+  for (std::size_t i = 0; i != windows; ++i)
+  {
+    for (std::size_t j = 0; j != window_size; ++j)
+    {
+      Q = point_double_complete(Q);
+    }
+
+    const std::uint64_t digit = _digit(windows - i - 1);
+    const proj_crv_p S        = point_add_complete(Q, table_select(_row, digit));
+    const std::uint64_t keep  = (0 - digit) >> 63;
+    fe_cmov(Q.x, S.x, keep);
+    fe_cmov(Q.y, S.y, keep);
+    fe_cmov(Q.z, S.z, keep);
+  }
+  return proj_to_jacobian(Q);
+}
+
+/*
+  _k * P for the precompute() table of P, constant time in _k where windowed_scalar_mul is not:
+  ECDH multiplies a peer key by a private key or an ephemeral secret. the table goes affine with
+  one inversion and then through row_scalar_mul_ct, only P = O (public) takes a shortcut
+*/
+inline jcbn_crv_p
+windowed_scalar_mul_ct(const std::vector<jcbn_crv_p>& _precomp, const sc& _k)
+{
+  static_assert(window_size == 4, "sc_window hands out 4 bit digits");
+
+  assert(_precomp.size() == std::size_t{1} << window_size);
+  if (is_identity(_precomp[1]))
+  {
+    return j_identity_element;
+  }
+
+  std::array<crv_p, std::size_t{1} << window_size> row;
+  batch_from_jacobian(_precomp, row);
+  return row_scalar_mul_ct(row.data(), [&](std::size_t _w) -> std::uint64_t { return sc_window(_k, _w); });
+}
+
+/* peers per chunk, bounds the table memory (16 affine points per peer) for long streams */
+static constexpr std::size_t fixed_scalar_chunk = 256;
+
+/*
+  _out[l] = k_l * P_l in affine for the precompute() tables _tables, k_l given by its window
+  digits _digit(l, w). constant time in the k_l: per chunk the tables go affine with one shared
+  inversion, every mul is a row_scalar_mul_ct and the results share one more. there is no
+  lockstep affine here on purpose, its incomplete adds have cases an attacker picking P_l could
+  aim for and then see in the timing. O tables give O
+*/
+template <class Digit>
+inline void
+scalar_mul_many_ct(std::span<const std::vector<jcbn_crv_p>* const> _tables, Digit&& _digit, std::span<crv_p> _out)
+{
+  assert(_tables.size() == _out.size());
+  static constexpr std::size_t m = std::size_t{1} << window_size;
+
+  std::vector<jcbn_crv_p> flat, S;
+  std::vector<crv_p> rows;
+
+  for (std::size_t base = 0; base < _out.size(); base += fixed_scalar_chunk)
+  {
+    const std::size_t n = std::min(fixed_scalar_chunk, _out.size() - base);
+
+    flat.clear();
+    for (std::size_t l = 0; l != n; ++l)
+    {
+      assert(_tables[base + l]->size() == m);
+      flat.insert(flat.end(), _tables[base + l]->begin(), _tables[base + l]->end());
+    }
+    rows.resize(flat.size());
+    batch_from_jacobian(flat, rows);
+
+    S.resize(n);
+    for (std::size_t l = 0; l != n; ++l)
+    {
+      const crv_p* row = &rows[l * m];
+      if (row[1] == a_identity_element)
+      {
+        S[l] = j_identity_element;
+        continue;
+      }
+      S[l] = row_scalar_mul_ct(row, [&](std::size_t _w) -> std::uint64_t { return _digit(base + l, _w); });
+    }
+    batch_from_jacobian(S, _out.subspan(base, n));
+  }
+
+  secure_wipe(S.data(), S.size() * sizeof(jcbn_crv_p));
+}
+
+/*
+  fixed scalar, many points (static server key against lots of peers): the scalar is cut into
+  its window digits once, after that every point runs the exact same sequence.
+*/
+struct scalar_plan
+{
+  std::array<std::uint8_t, 256 / window_size> digits{}; // most significant window first
+  std::size_t count = 0;
+};
+
+/* public scalars, as many windows as the bitlength needs */
+inline scalar_plan
+make_scalar_plan(const GmpWrapper& _num)
+{
+  scalar_plan out;
+  out.count = (_num.bitlength() + window_size - 1) / window_size;
+
+  for (std::size_t i = 0; i != out.count; ++i)
+  {
+    out.digits[i] = static_cast<std::uint8_t>(_num.get_bits((out.count - i - 1) * window_size, window_size));
+  }
+  return out;
+}
+
+/* secret scalars, always all 64 windows so the plan doesn't give the bitlength away */
+inline scalar_plan
+make_scalar_plan(const sc& _num)
+{
+  scalar_plan out;
+  out.count = out.digits.size();
+
+  for (std::size_t i = 0; i != out.count; ++i)
+  {
+    out.digits[i] = static_cast<std::uint8_t>(sc_window(_num, out.count - i - 1));
+  }
+  return out;
+}
+
+/*
+  _out[i] = k * _points[i] in affine, k given by _plan. constant time in k (the plan of a
+  private key): per chunk the peer tables are built and handed to scalar_mul_many_ct, so every
+  window does its doublings and the masked select and add whatever the digit
+*/
+inline void
+fixed_scalar_mul_many(const scalar_plan& _plan, std::span<const crv_p> _points, std::span<crv_p> _out)
+{
+  assert(_points.size() == _out.size());
+
+  // windows above count are 0, they still run
+  const auto digit = [&](std::size_t, std::size_t _w) -> std::size_t { return _w < _plan.count ? _plan.digits[_plan.count - _w - 1] : 0; };
+
+  std::vector<std::vector<jcbn_crv_p>> tables;
+  std::vector<const std::vector<jcbn_crv_p>*> table_ptrs;
+
+  for (std::size_t base = 0; base < _points.size(); base += fixed_scalar_chunk)
+  {
+    const std::size_t n = std::min(fixed_scalar_chunk, _points.size() - base);
+
+    tables.resize(n);
+    table_ptrs.resize(n);
+    for (std::size_t l = 0; l != n; ++l)
+    {
+      tables[l]     = precompute(to_jacobian(_points[base + l]));
+      table_ptrs[l] = &tables[l];
+    }
+
+    scalar_mul_many_ct(table_ptrs, digit, _out.subspan(base, n));
+  }
+}
+
+/*
+  start point of the lockstep below, x is sha256 of the uncompressed G (the bip 341 "H"), so
+  nobody knows its discrete log
+*/
+inline const crv_p&
+fixed_base_offset()
+{
+  static const crv_p H = []
+  {
+    const fe x = {{0x47BFEE9ACE803AC0ull, 0x078A5A0F28EC96D5ull, 0xB78B4B6035E97A5Eull, 0x50929B74C1A04954ull}};
+    fe y;
+    [[maybe_unused]] const bool on_curve = fe_sqrt(y, fe_add(fe_mul(fe_sqr(x), x), fe_mul_small(fe_one, 7)));
+    assert(on_curve);
+    return crv_p{x, (y.n[0] & 1) ? fe_neg(y) : y};
+  }();
+
+  return H;
+}
+
+/* below this many keys an inversion per step costs more than the cheaper affine adds save */
+static constexpr std::size_t fixed_base_lockstep_min = 32;
+
+/*
+  _out[l] = _k[l] * G in affine, _k as 4 little endian limbs. the callers hand in private keys
+  and nonces, so this is constant time in _k like fixed_base_mul: every key starts at
+  fixed_base_offset() and does one lockstep affine add (one shared inversion) per window with
+  the entry from fixed_base_select, a zero digit masks its sum out, and the last step takes the
+  offset off again. starting off O means an incomplete affine add only ever meets P == +-T if
+  someone knows the discrete log of the offset. k = 0 (or such a collision) does hit it, that
+  batch is redone one key at a time. small batches go through fixed_base_mul and one
+  batch_from_jacobian.
+*/
+inline void
+fixed_base_mul_many(std::span<const std::array<std::uint64_t, 4>> _k, std::span<crv_p> _out)
+{
+  assert(_k.size() == _out.size());
+
+  const auto one_at_a_time = [&]
+  {
+    std::vector<jcbn_crv_p> J(_k.size());
+    for (std::size_t l = 0; l != _k.size(); ++l)
+    {
+      J[l] = fixed_base_mul(_k[l]);
+    }
+    batch_from_jacobian(J, _out);
+  };
+
+  if (_k.size() < fixed_base_lockstep_min)
+  {
+    one_at_a_time();
+    return;
+  }
+
+  static constexpr std::size_t windows = 256 / window_size;
+  const auto& table                    = fixed_base_table();
+  const crv_p& H                       = fixed_base_offset();
+  const crv_p minus_H{H.x, fe_neg(H.y)};
+
+  const std::size_t n = _k.size();
+  std::vector<crv_p> T(n);
+  std::vector<fe> den(n), scratch(n);
+  std::fill(_out.begin(), _out.end(), H);
+
+  std::uint64_t degenerate = 0;
+  for (std::size_t w = 0; w <= windows; ++w)
+  {
+    for (std::size_t l = 0; l != n; ++l)
+    {
+      T[l]   = w != windows ? fixed_base_select(table, w, fixed_base_digit(_k[l], w)) : minus_H;
+      den[l] = fe_sub(T[l].x, _out[l].x);
+      degenerate |= fe_is_zero(den[l]);
+    }
+
+    fe_batch_inv(den, scratch);
+
+    for (std::size_t l = 0; l != n; ++l)
+    {
+      crv_p& q     = _out[l];
+      const fe lam = fe_mul(fe_sub(T[l].y, q.y), den[l]);
+      const fe x3  = fe_sub(fe_sub(fe_sqr(lam), q.x), T[l].x);
+      const fe y3  = fe_sub(fe_mul(lam, fe_sub(q.x, x3)), q.y);
+
+      const std::uint64_t keep = w != windows ? (0 - fixed_base_digit(_k[l], w)) >> 63 : 1;
+      fe_cmov(q.x, x3, keep);
+      fe_cmov(q.y, y3, keep);
+    }
+  }
+
+  secure_wipe(T.data(), T.size() * sizeof(crv_p));
+  if (degenerate) [[unlikely]]
+  {
+    one_at_a_time();
+  }
+}
+
+/*
+  _u1 G + _u2 _Q as one joint (shamir / straus) multiply: a single chain of doublings, per
+  window one mixed add from the affine G table (window 0 of the fixed base table) and one add
+  from the jacobian table of _Q.
+*/
+inline jcbn_crv_p
+double_base_mul(const sc& _u1, const crv_p& _Q, const sc& _u2)
+{
+  static_assert(window_size == 4, "sc_window hands out 4 bit digits");
+
+  const auto& G_table = fixed_base_table();
+  const auto Q_table  = precompute(to_jacobian(_Q));
+
+  jcbn_crv_p R{j_identity_element};
+  const std::size_t m = (std::max(sc_bitlength(_u1), sc_bitlength(_u2)) + window_size - 1) / window_size;
+
+  for (std::size_t i = 0; i != m; ++i)
+  {
+    for (std::size_t j = 0; j != window_size; ++j)
+    {
+      R = point_double(R);
+    }
+
+    const std::size_t w1 = sc_window(_u1, m - i - 1);
+    const std::size_t w2 = sc_window(_u2, m - i - 1);
+
+    if (w1 != 0)
+    {
+      R = point_add_mixed(R, G_table[w1]);
+    }
+    if (w2 != 0)
+    {
+      R = point_add(R, Q_table[w2]);
+    }
+  }
+  return R;
+}
+
+} // namespace blue_crypto::secp256k1
@@ -0,0 +1,320 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "curve.h"
+#include "field_simd.h"
+
+/*
+  lane parallel jacobian point code, runs B::width independent scalar muls in lockstep.
+
+  the lane formulas have no special cases at all, identity / digit 0 is handled by per lane
+  blending in the scalar mul and the (practically unreachable) P == +-Q case is detected after
+  the fact (Z ends up 0) and that lane is redone on the scalar path.
+*/
+
+namespace blue_crypto::secp256k1
+{
+
+template <class B>
+struct jcbn_crv_lanes
+{
+  typename B::elem x, y, z;
+};
+
+template <class B>
+inline void
+copy_lane(typename B::elem& _dst, const typename B::elem& _src, std::size_t _lane) noexcept
+{
+  for (std::size_t i = 0; i != B::limbs; ++i)
+  {
+    _dst.v[i][_lane] = _src.v[i][_lane];
+  }
+}
+
+template <class B>
+inline void
+copy_lane(jcbn_crv_lanes<B>& _dst, const jcbn_crv_lanes<B>& _src, std::size_t _lane) noexcept
+{
+  copy_lane<B>(_dst.x, _src.x, _lane);
+  copy_lane<B>(_dst.y, _src.y, _lane);
+  copy_lane<B>(_dst.z, _src.z, _lane);
+}
+
+template <class B>
+inline void
+put_lane(jcbn_crv_lanes<B>& _dst, std::size_t _lane, const jcbn_crv_p& _p) noexcept
+{
+  B::put(_dst.x, _lane, _p.x);
+  B::put(_dst.y, _lane, _p.y);
+  B::put(_dst.z, _lane, _p.z);
+}
+
+template <class B>
+inline jcbn_crv_p
+get_lane(const jcbn_crv_lanes<B>& _src, std::size_t _lane) noexcept
+{
+  return {B::get(_src.x, _lane), B::get(_src.y, _lane), B::get(_src.z, _lane)};
+}
+
+/* dbl-2009-l, same as the scalar point_double minus the y == 0 check */
+template <class B>
+inline void
+point_double(jcbn_crv_lanes<B>& _out, const jcbn_crv_lanes<B>& _p1) noexcept
+{
+  typename B::elem a, b, c, d, e, t;
+
+  B::sqr(a, _p1.x);
+  B::sqr(b, _p1.y);
+  B::sqr(c, b);
+
+  B::add(d, _p1.x, b);
+  B::sqr(d, d);
+  B::sub(d, d, a);
+  B::sub(d, d, c);
+  B::add(d, d, d);
+
+  B::add(e, a, a);
+  B::add(e, e, a);
+
+  // z first, _out may alias _p1
+  B::mul(t, _p1.y, _p1.z);
+  B::add(_out.z, t, t);
+
+  B::sqr(t, e);
+  B::sub(t, t, d);
+  B::sub(_out.x, t, d);
+
+  B::sub(t, d, _out.x);
+  B::mul(t, e, t);
+  B::add(c, c, c);
+  B::add(c, c, c);
+  B::add(c, c, c);
+  B::sub(_out.y, t, c);
+}
+
+/* generic jacobian add, garbage if either input is the identity or _p1 == +-_p2 */
+template <class B>
+inline void
+point_add(jcbn_crv_lanes<B>& _out, const jcbn_crv_lanes<B>& _p1, const jcbn_crv_lanes<B>& _p2) noexcept
+{
+  typename B::elem z1z1, z2z2, u1, u2, s1, s2, h, r, hh, hhh, v, t;
+
+  B::sqr(z1z1, _p1.z);
+  B::sqr(z2z2, _p2.z);
+  B::mul(u1, _p1.x, z2z2);
+  B::mul(u2, _p2.x, z1z1);
+  B::mul(t, _p2.z, z2z2);
+  B::mul(s1, _p1.y, t);
+  B::mul(t, _p1.z, z1z1);
+  B::mul(s2, _p2.y, t);
+
+  B::sub(h, u2, u1);
+  B::sub(r, s2, s1);
+  B::sqr(hh, h);
+  B::mul(hhh, h, hh);
+  B::mul(v, u1, hh);
+
+  B::mul(t, _p1.z, _p2.z);
+  B::mul(_out.z, t, h);
+
+  B::sqr(t, r);
+  B::sub(t, t, hhh);
+  B::sub(t, t, v);
+  B::sub(_out.x, t, v);
+
+  B::sub(t, v, _out.x);
+  B::mul(t, r, t);
+  B::mul(s1, s1, hhh);
+  B::sub(_out.y, t, s1);
+}
+
+/* B::width scalar muls, _precomp[l] is the precompute() table of lane l */
+template <class B>
+void
+windowed_scalar_mul(const std::vector<jcbn_crv_p>* const* _precomp, const GmpWrapper* _nums, jcbn_crv_p* _out)
+{
+  static constexpr std::size_t width   = B::width;
+  static constexpr std::size_t windows = 256 / window_size;
+
+  std::array<std::array<std::uint64_t, 4>, width> k;
+  for (std::size_t l = 0; l != width; ++l)
+  {
+    _nums[l].to_limbs(k[l].data(), 4);
+  }
+
+  std::array<jcbn_crv_lanes<B>, std::size_t{1} << window_size> table;
+  for (std::size_t e = 0; e != table.size(); ++e)
+  {
+    for (std::size_t l = 0; l != width; ++l)
+    {
+      put_lane(table[e], l, (*_precomp[l])[e]);
+    }
+  }
+
+  jcbn_crv_lanes<B> Q{}, T, R;
+  std::array<bool, width> live{};
+  bool any_live = false;
+
+  for (std::size_t i = 0; i != windows; ++i)
+  {
+    if (any_live) [[likely]]
+    {
+      for (std::size_t j = 0; j != window_size; ++j)
+      {
+        point_double(Q, Q);
+      }
+    }
+
+    const std::size_t w = windows - i - 1;
+    std::array<std::size_t, width> digit;
+    bool any_digit = false;
+
+    for (std::size_t l = 0; l != width; ++l)
+    {
+      digit[l] = (k[l][w / 16] >> ((w % 16) * window_size)) & ((1u << window_size) - 1);
+      copy_lane(T, table[digit[l]], l);
+      any_digit |= digit[l] != 0;
+    }
+
+    if (!any_digit) [[unlikely]]
+    {
+      continue;
+    }
+
+    point_add(R, Q, T);
+
+    for (std::size_t l = 0; l != width; ++l)
+    {
+      if (digit[l] == 0)
+      {
+        continue;
+      }
+      copy_lane(Q, live[l] ? R : T, l);
+      live[l] = any_live = true;
+    }
+  }
+
+  for (std::size_t l = 0; l != width; ++l)
+  {
+    if (!live[l])
+    {
+      _out[l] = j_identity_element;
+      continue;
+    }
+
+    _out[l] = get_lane(Q, l);
+
+    if (is_identity(_out[l])) [[unlikely]]
+    {
+      _out[l] = windowed_scalar_mul(*_precomp[l], _nums[l]);
+    }
+  }
+}
+
+enum class lane_backend
+{
+  scalar,
+  avx2,
+  ifma
+};
+
+inline lane_backend
+select_lane_backend() noexcept
+{
+  if (lanes_ifma::supported())
+  {
+    return lane_backend::ifma;
+  }
+  if (lanes_avx2::supported())
+  {
+    return lane_backend::avx2;
+  }
+  return lane_backend::scalar;
+}
+
+inline const lane_backend lane_kernel = select_lane_backend();
+
+[[gnu::pure]] inline const char*
+lane_backend_name(lane_backend _b) noexcept
+{
+  switch (_b)
+  {
+  case lane_backend::ifma:
+    return lanes_ifma::name;
+  case lane_backend::avx2:
+    return lanes_avx2::name;
+  default:
+    return "scalar";
+  }
+}
+
+/* full groups go through backend B, the tail through the scalar path */
+template <class B>
+void
+batch_windowed_scalar_mul(std::span<const std::vector<jcbn_crv_p>* const> _precomps, std::span<const GmpWrapper> _nums,
+                          std::span<jcbn_crv_p> _out)
+{
+  assert(_precomps.size() == _nums.size() && _nums.size() == _out.size());
+
+  std::size_t i = 0;
+  for (; i + B::width <= _nums.size(); i += B::width)
+  {
+    windowed_scalar_mul<B>(&_precomps[i], &_nums[i], &_out[i]);
+  }
+  for (; i != _nums.size(); ++i)
+  {
+    _out[i] = windowed_scalar_mul(*_precomps[i], _nums[i]);
+  }
+}
+
+/* runs 4 (avx2) or 8 (ifma) ECDHs per instruction, whatever the host supports */
+inline void
+batch_windowed_scalar_mul(std::span<const std::vector<jcbn_crv_p>* const> _precomps, std::span<const GmpWrapper> _nums,
+                          std::span<jcbn_crv_p> _out)
+{
+  switch (lane_kernel)
+  {
+  case lane_backend::ifma:
+    return batch_windowed_scalar_mul<lanes_ifma>(_precomps, _nums, _out);
+  case lane_backend::avx2:
+    return batch_windowed_scalar_mul<lanes_avx2>(_precomps, _nums, _out);
+  default:
+    for (std::size_t i = 0; i != _nums.size(); ++i)
+    {
+      _out[i] = windowed_scalar_mul(*_precomps[i], _nums[i]);
+    }
+  }
+}
+
+/*
+  square roots of a whole batch (point decompression). each one is a 255 squaring chain with
+  nothing to share between them, so they just go 8 at a time through ifma. avx2's 26 bit limbs
+  lose to mulx here
+*/
+inline void
+fe_sqrt_many(std::span<const fe> _in, std::span<fe> _out, std::span<std::uint8_t> _ok) noexcept
+{
+  assert(_out.size() == _in.size() && _ok.size() == _in.size());
+
+  if (lane_kernel == lane_backend::ifma)
+  {
+    return blue_crypto::fe_sqrt_many<lanes_ifma>(_in, _out, _ok);
+  }
+  if (!fe_kernel.adx && lane_kernel == lane_backend::avx2)
+  {
+    return blue_crypto::fe_sqrt_many<lanes_avx2>(_in, _out, _ok);
+  }
+  for (std::size_t i = 0; i != _in.size(); ++i)
+  {
+    fe root;
+    _ok[i]  = fe_sqrt(root, _in[i]);
+    _out[i] = root;
+  }
+}
+
+} // namespace blue_crypto::secp256k1
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "curve.h"
+
+/*
+  public keys of consecutive / strided private keys, (k + i*s)*G for i = 0, 1, 2, ...
+
+  P_{i+1} = P_i + S with S = s*G, so no scalar mul per key. the walk goes in groups: from a
+  center C the group is C, C + S, ..., C + (m-1)S, using the affine table S, 2S, ..., mS. all
+  m slopes of a group share one inversion and C + mS is the next center, so per key that is
+  one affine add (~6M incl. its share of the batch inversion) and no from_jacobian at all.
+*/
+
+namespace blue_crypto::secp256k1
+{
+
+static constexpr std::size_t walk_group = 1024;
+
+/* S, 2S, ..., _m S in affine */
+inline std::vector<crv_p>
+walk_steps(const crv_p& _step, std::size_t _m)
+{
+  std::vector<jcbn_crv_p> multiples;
+  multiples.reserve(_m);
+
+  const jcbn_crv_p S = to_jacobian(_step);
+  jcbn_crv_p next    = S;
+
+  for (std::size_t j = 0; j != _m; ++j)
+  {
+    multiples.push_back(next);
+    next = point_add(next, S);
+  }
+
+  std::vector<crv_p> out(_m);
+  batch_from_jacobian(multiples, out);
+  return out;
+}
+
+namespace detail
+{
+
+/* affine add through the jacobian code, for the cases the slope can't handle (O, P == +-Q) */
+inline crv_p
+walk_add_slow(const crv_p& _p1, bool _p1_inf, const crv_p& _p2)
+{
+  return _p1_inf ? _p2 : from_jacobian(point_add(to_jacobian(_p1), to_jacobian(_p2)));
+}
+
+} // namespace detail
+
+/* _out[i] = _start + i*S, _steps from walk_steps(S, m) with m >= 1. _start may be O */
+inline void
+walk_range(crv_p _start, std::span<const crv_p> _steps, std::span<crv_p> _out)
+{
+  assert(!_steps.empty());
+
+  const std::size_t m = _steps.size();
+  std::vector<fe> den(m), scratch(m);
+
+  crv_p C       = _start;
+  bool inf      = C == a_identity_element;
+  std::size_t i = 0;
+
+  while (i != _out.size())
+  {
+    // _out[i + j] = C + jS for j in [0, g), den[j - 1] is the slope denominator for jS, j in [1, g]
+    const std::size_t g = std::min(m, _out.size() - i);
+    const std::size_t d = (g == m) ? m : g - 1;
+
+    for (std::size_t j = 0; j != d; ++j)
+    {
+      den[j] = fe_sub(_steps[j].x, C.x);
+    }
+    fe_batch_inv(std::span{den}.first(d), scratch);
+
+    _out[i] = inf ? a_identity_element : C;
+
+    for (std::size_t j = 1; j <= d; ++j)
+    {
+      const crv_p& t = _steps[j - 1];
+      crv_p r;
+
+      if (inf || fe_is_zero(den[j - 1])) [[unlikely]]
+      {
+        r = detail::walk_add_slow(C, inf, t);
+      }
+      else
+      {
+        const fe lam = fe_mul(fe_sub(t.y, C.y), den[j - 1]);
+        r.x          = fe_sub(fe_sub(fe_sqr(lam), C.x), t.x);
+        r.y          = fe_sub(fe_mul(lam, fe_sub(C.x, r.x)), C.y);
+      }
+
+      if (j != g)
+      {
+        _out[i + j] = r;
+      }
+      else
+      {
+        // C + mS, center of the next group
+        C   = r;
+        inf = C == a_identity_element;
+      }
+    }
+    i += g;
+  }
+}
+
+/*
+  _out[i] = (_start + i*_stride)*G, split into one contiguous stride of the range per thread.
+  _threads = 0 uses every core
+*/
+inline void
+walk_keys(const GmpWrapper& _start, const GmpWrapper& _stride, std::span<crv_p> _out, unsigned _threads = 0)
+{
+  if (_out.empty())
+  {
+    return;
+  }
+
+  if (_threads == 0)
+  {
+    _threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  const auto G_precomp  = precompute(to_jacobian(G));
+  const std::size_t per = (_out.size() + _threads - 1) / _threads;
+  const auto steps      = walk_steps(from_jacobian(windowed_scalar_mul(G_precomp, _stride)), std::min(walk_group, per));
+
+  const auto work = [&](std::size_t _from)
+  {
+    const std::uint64_t off = _from;
+    const GmpWrapper k      = _start + _stride * GmpWrapper::from_limbs(&off, 1);
+    const std::size_t n     = std::min(per, _out.size() - _from);
+
+    walk_range(from_jacobian(windowed_scalar_mul(G_precomp, k)), steps, _out.subspan(_from, n));
+  };
+
+  std::vector<std::thread> pool;
+  for (std::size_t from = per; from < _out.size(); from += per)
+  {
+    pool.emplace_back(work, from);
+  }
+  work(0);
+
+  for (auto& t : pool)
+  {
+    t.join();
+  }
+}
+
+} // namespace blue_crypto::secp256k1
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "chacha20.h"
+#include "rng.h"
+
+/*
+  ChaCha20 DRBG for bulk key material: the kernel is asked for 32 bytes once per reseed
+  interval and everything else is ChaCha20 key stream, 16 (avx512) / 8 (avx2) blocks per
+  kernel call.
+
+  every refill is fast key erasure: a fresh chacha20 under the current key writes the next
+  key over the old one first and the output after it, so the state never holds anything
+  that reproduces bytes already handed out. requests of a buffer or more skip the buffer and
+  take the key stream straight into the output.
+
+  fork safety: the pthread_atfork child handler in rng.h bumps detail::fork_generation, a
+  generator that sees a new generation reseeds from the kernel before its next byte, so parent and child
+  never share a stream. one generator per thread (local()), it is not synchronized.
+*/
+
+namespace blue_crypto
+{
+
+/* kernel reseed interval, in bytes handed out */
+static constexpr std::uint64_t drbg_reseed_bytes = std::uint64_t{1} << 30;
+
+class chacha_drbg
+{
+public:
+  chacha_drbg() { reseed(); }
+
+  chacha_drbg(const chacha_drbg&)            = delete;
+  chacha_drbg& operator=(const chacha_drbg&) = delete;
+
+  ~chacha_drbg()
+  {
+    secure_wipe(key_.data(), key_.size());
+    secure_wipe(buf_.data(), buf_.size());
+  }
+
+  /* this thread's generator, seeded on first use */
+  static chacha_drbg&
+  local()
+  {
+    thread_local chacha_drbg rng;
+    return rng;
+  }
+
+  /* new key from getrandom (just the 32 bytes, not an os_random block), drops whatever is buffered */
+  void
+  reseed()
+  {
+    kernel_random(key_);
+    generation_ = detail::fork_generation.load(std::memory_order_relaxed);
+    issued_     = 0;
+    pos_        = buf_.size();
+  }
+
+  void
+  fill(std::span<std::byte> _out)
+  {
+    if (generation_ != detail::fork_generation.load(std::memory_order_relaxed) || issued_ >= drbg_reseed_bytes) [[unlikely]]
+    {
+      reseed();
+    }
+    issued_ += _out.size();
+
+    const std::size_t head = std::min(_out.size(), buf_.size() - pos_);
+    std::copy_n(buf_.data() + pos_, head, _out.data());
+    // handed out bytes are not kept around
+    secure_wipe(buf_.data() + pos_, head);
+    pos_ += head;
+    _out = _out.subspan(head);
+
+    if (_out.size() >= buf_.size())
+    {
+      rekey_into(_out);
+      return;
+    }
+    if (!_out.empty())
+    {
+      rekey_into(buf_);
+      std::copy_n(buf_.data(), _out.size(), _out.data());
+      secure_wipe(buf_.data(), _out.size());
+      pos_ = _out.size();
+    }
+  }
+
+  std::uint64_t
+  next_u64()
+  {
+    std::uint64_t out;
+    fill(std::as_writable_bytes(std::span{&out, 1}));
+    return out;
+  }
+
+private:
+  /* next key, then _out, both from one key stream under the current key */
+  void
+  rekey_into(std::span<std::byte> _out) noexcept
+  {
+    static constexpr std::array<std::byte, chacha20_nonce_size> nonce{};
+
+    chacha20 stream{key_, nonce};
+    stream.keystream(key_);
+    stream.keystream(_out);
+  }
+
+  std::array<std::byte, chacha20_key_size> key_;
+  std::array<std::byte, 4096> buf_;
+  std::size_t pos_ = buf_.size();
+  std::uint64_t issued_ = 0;
+  std::uint64_t generation_ = 0;
+};
+
+/* fills with chacha_drbg::local(), the bigint_rand_func signature that BigInt::rand_bits takes (bigint.hpp) */
+inline void
+drbg_rand_bytes(std::uint8_t* _dst, int _n)
+{
+  chacha_drbg::local().fill(std::as_writable_bytes(std::span{_dst, static_cast<std::size_t>(_n)}));
+}
+
+} // namespace blue_crypto
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "curve.h"
+#include "curve_batch.h"
+#include "curve_simd.h"
+#include "rng.h"
+#include "sha256.h"
+#include "sha256_mb.h"
+
+/*
+  x only ECDH: most protocols hash just the x coordinate of the shared point, so the result
+  is X / Z^2 (one fe_inv, a squaring and a multiply) and y is never normalized. x(k P) is the
+  same for P and -P, so an x only peer key is lifted with whichever root fe_sqrt returns; the
+  root is still needed as the curve check (an x off the curve would put the multiply on the
+  twist). the batch version shares one inversion across all the Z. the sc overloads are
+  constant time in the scalar (windowed_scalar_mul_ct), the GmpWrapper ones are not and are
+  only meant for public scalars.
+*/
+
+namespace blue_crypto::secp256k1
+{
+
+static constexpr std::size_t ecdh_x_size = 32;
+
+/*
+  x of _num * P for the precompute() table of P, false if that is O (a zero / multiple of n
+  scalar). variable time in _num
+*/
+inline bool
+ecdh_x(fe& _out, const std::vector<jcbn_crv_p>& _precomp, const GmpWrapper& _num)
+{
+  const jcbn_crv_p S = windowed_scalar_mul(_precomp, _num);
+  if (is_identity(S))
+  {
+    return false;
+  }
+  _out = affine_x(S);
+  return true;
+}
+
+/* same for a secret _num, constant time in it */
+inline bool
+ecdh_x(fe& _out, const std::vector<jcbn_crv_p>& _precomp, const sc& _num)
+{
+  const jcbn_crv_p S = windowed_scalar_mul_ct(_precomp, _num);
+  if (is_identity(S))
+  {
+    return false;
+  }
+  _out = affine_x(S);
+  return true;
+}
+
+/*
+  32 byte x only peer key in, 32 byte big endian x of the shared point out. false if the peer
+  x is >= p or not on the curve, or the result is O
+*/
+inline bool
+ecdh_xonly(std::byte* _out, const std::byte* _peer_x, const sc& _priv)
+{
+  crv_p P;
+  fe x;
+  if (!fe_from_bytes(x, _peer_x) || !lift_x(P, x, false) || !ecdh_x(x, precompute(to_jacobian(P)), _priv))
+  {
+    return false;
+  }
+  fe_to_bytes(x, _out);
+  return true;
+}
+
+/*
+  ECDH straight into HKDF-SHA256: the 32 byte big endian x of _num * P is the input keying
+  material, written to the stack and hashed from there (then wiped). false if the product is O
+*/
+inline bool
+ecdh_hkdf(std::span<std::byte> _key, const std::vector<jcbn_crv_p>& _precomp, const sc& _num, std::span<const std::byte> _salt = {},
+          std::span<const std::byte> _info = {})
+{
+  fe x;
+  if (!ecdh_x(x, _precomp, _num))
+  {
+    return false;
+  }
+
+  std::byte ikm[ecdh_x_size];
+  fe_to_bytes(x, ikm);
+  hkdf_sha256(_key, ikm, _salt, _info);
+
+  secure_wipe(ikm, sizeof(ikm));
+  secure_wipe(&x, sizeof(x));
+  return true;
+}
+
+/*
+  batch_windowed_scalar_mul (lane parallel where the host has it) and then only X / Z^2 of
+  every result with one fe_batch_inv. _ok gets 0 where the product was O (_out is 0 there).
+  variable time in the scalars
+*/
+inline void
+ecdh_x_many(std::span<const std::vector<jcbn_crv_p>* const> _precomps, std::span<const GmpWrapper> _nums, std::span<fe> _out,
+            std::span<std::uint8_t> _ok)
+{
+  const std::size_t n = _nums.size();
+  assert(_precomps.size() == n && _out.size() == n && _ok.size() == n);
+
+  std::vector<jcbn_crv_p> S(n);
+  batch_windowed_scalar_mul(_precomps, _nums, S);
+
+  std::vector<fe> zi(n);
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    zi[i] = S[i].z;
+  }
+  fe_batch_inv(zi);
+
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    _ok[i]  = !is_identity(S[i]);
+    _out[i] = fe_mul(S[i].x, fe_sqr(zi[i]));
+  }
+}
+
+/* same for secret scalars through scalar_mul_many_ct, no GmpWrapper copies of them */
+inline void
+ecdh_x_many(std::span<const std::vector<jcbn_crv_p>* const> _precomps, std::span<const sc> _nums, std::span<fe> _out,
+            std::span<std::uint8_t> _ok)
+{
+  const std::size_t n = _nums.size();
+  assert(_precomps.size() == n && _out.size() == n && _ok.size() == n);
+
+  const auto digit = [&](std::size_t _l, std::size_t _w) -> std::uint64_t { return sc_window(_nums[_l], _w); };
+
+  std::vector<crv_p> S(n);
+  scalar_mul_many_ct(_precomps, digit, S);
+
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    _ok[i]  = S[i] != a_identity_element;
+    _out[i] = S[i].x;
+  }
+  secure_wipe(S.data(), S.size() * sizeof(crv_p));
+}
+
+namespace detail
+{
+
+inline void
+ecdh_sha256_xs(std::span<const fe> _xs, std::span<sha256_digest> _out, std::span<const std::uint8_t> _ok)
+{
+  const std::size_t n = _xs.size();
+  assert(_out.size() == n && _ok.size() == n);
+
+  std::vector<std::byte> bytes(n * ecdh_x_size);
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    fe_to_bytes(_ok[i] ? _xs[i] : fe_zero, &bytes[i * ecdh_x_size]);
+  }
+
+  sha256_many(bytes, ecdh_x_size, _out);
+  secure_wipe(bytes.data(), bytes.size());
+}
+
+} // namespace detail
+
+/*
+  ecdh_x_many then SHA-256 of every 32 byte x, the usual "hash the shared x" secret. the
+  hashes go through sha256_many, so a batch of 16 secrets costs about one multi buffer
+  compression instead of 16 single ones. _out[i] is the hash of zeros where _ok[i] is 0
+*/
+inline void
+ecdh_sha256_many(std::span<const std::vector<jcbn_crv_p>* const> _precomps, std::span<const GmpWrapper> _nums,
+                 std::span<sha256_digest> _out, std::span<std::uint8_t> _ok)
+{
+  std::vector<fe> xs(_nums.size());
+  ecdh_x_many(_precomps, _nums, xs, _ok);
+  detail::ecdh_sha256_xs(xs, _out, _ok);
+  secure_wipe(xs.data(), xs.size() * sizeof(fe));
+}
+
+inline void
+ecdh_sha256_many(std::span<const std::vector<jcbn_crv_p>* const> _precomps, std::span<const sc> _nums, std::span<sha256_digest> _out,
+                 std::span<std::uint8_t> _ok)
+{
+  std::vector<fe> xs(_nums.size());
+  ecdh_x_many(_precomps, _nums, xs, _ok);
+  detail::ecdh_sha256_xs(xs, _out, _ok);
+  secure_wipe(xs.data(), xs.size() * sizeof(fe));
+}
+
+} // namespace blue_crypto::secp256k1
@@ -0,0 +1,496 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "curve_batch.h"
+#include "drbg.h"
+#include "msm.h"
+#include "scalar.h"
+#include "sha256.h"
+
+/*
+  ECDSA over secp256k1 with deterministic nonces (RFC 6979, HMAC-SHA256).
+
+  the nonce point k*G comes off the fixed base table (fixed_base_mul, 64 adds and no
+  doublings), r = X / Z^2 mod n needs the one fe_inv and s the one sc_inv. the batch version
+  shares both: the nonce points come out affine from the lockstep adds and all k^-1 come
+  from a single sc_batch_inv. s is normalized to the low half (BIP 62 / 146 style).
+  everything the nonce goes through is constant time in it: both fixed base muls select their
+  table entries with masks and add in every window, fe_inv / sc_inv are fixed chains.
+*/
+
+namespace blue_crypto::secp256k1
+{
+
+struct ecdsa_sig
+{
+  sc r, s;
+
+  bool
+  operator==(const ecdsa_sig& other) const
+  {
+    return (r == other.r) && (s == other.s);
+  }
+};
+
+/* r || s, 32 bytes big endian each */
+inline void
+to_compact(const ecdsa_sig& _sig, std::byte* _out) noexcept
+{
+  sc_to_bytes(_sig.r, _out);
+  sc_to_bytes(_sig.s, _out + 32);
+}
+
+/* false if r or s is out of range (0 or >= n) */
+inline bool
+from_compact(ecdsa_sig& _sig, const std::byte* _in) noexcept
+{
+  const bool r_ok = sc_from_bytes(_sig.r, _in);
+  const bool s_ok = sc_from_bytes(_sig.s, _in + 32);
+  return r_ok && s_ok && !sc_is_zero(_sig.r) && !sc_is_zero(_sig.s);
+}
+
+/* RFC 6979 section 3.2 with HMAC-SHA256 and qlen = 256, next() gives k, k', k'', ... */
+class rfc6979
+{
+public:
+  rfc6979(const sc& _priv, const std::byte* _hash)
+  {
+    std::array<std::byte, 32> x, h1;
+    sc_to_bytes(_priv, x.data());
+
+    // bits2octets: the hash reduced mod n
+    sc z;
+    sc_from_bytes(z, _hash);
+    sc_to_bytes(z, h1.data());
+
+    V_.fill(std::byte{0x01});
+    K_.fill(std::byte{0x00});
+
+    for (const std::byte sep : {std::byte{0x00}, std::byte{0x01}})
+    {
+      K_ = hmac_sha256{K_}.update(V_).update({&sep, 1}).update(x).update(h1).finalize();
+      V_ = hmac_sha256::mac(K_, V_);
+    }
+
+    secure_wipe(x.data(), x.size());
+  }
+
+  rfc6979(const rfc6979&)            = delete;
+  rfc6979& operator=(const rfc6979&) = delete;
+
+  ~rfc6979()
+  {
+    secure_wipe(K_.data(), K_.size());
+    secure_wipe(V_.data(), V_.size());
+  }
+
+  sc
+  next()
+  {
+    if (!first_)
+    {
+      reseed();
+    }
+    first_ = false;
+
+    for (;;)
+    {
+      V_ = hmac_sha256::mac(K_, V_);
+
+      sc k;
+      if (sc_from_bytes(k, V_.data()) && !sc_is_zero(k)) [[likely]]
+      {
+        return k;
+      }
+      reseed();
+    }
+  }
+
+private:
+  void
+  reseed()
+  {
+    const std::byte zero{0x00};
+    K_ = hmac_sha256{K_}.update(V_).update({&zero, 1}).finalize();
+    V_ = hmac_sha256::mac(K_, V_);
+  }
+
+  sha256_digest K_, V_;
+  bool first_ = true;
+};
+
+namespace detail
+{
+
+/* recovery id of the nonce point: bit 0 = y odd, bit 1 = x >= n (r = x - n) */
+inline std::uint8_t
+ecdsa_recid(const crv_p& _R) noexcept
+{
+  const sc r          = sc_from_fe(_R.x);
+  const bool overflow = fe{{r.n[0], r.n[1], r.n[2], r.n[3]}} != _R.x;
+  return static_cast<std::uint8_t>((_R.y.n[0] & 1) | (overflow << 1));
+}
+
+/*
+  s = k^-1 (z + r d), low s. zero if the signature has to be retried with the next nonce.
+  negating s means the signature is for -R, so the parity bit of _recid flips
+*/
+inline sc
+ecdsa_s(const sc& _kinv, const sc& _z, const sc& _r, const sc& _priv, std::uint8_t& _recid) noexcept
+{
+  const sc s = sc_mul(_kinv, sc_add(_z, sc_mul(_r, _priv)));
+  if (sc_is_high(s))
+  {
+    _recid ^= 1;
+    return sc_neg(s);
+  }
+  return s;
+}
+
+} // namespace detail
+
+/* _hash is the 32 byte message digest. _recid (optional) gets the hint for batch verify / recovery */
+inline ecdsa_sig
+ecdsa_sign(const sc& _priv, const std::byte* _hash, std::uint8_t* _recid = nullptr)
+{
+  sc z;
+  sc_from_bytes(z, _hash);
+
+  rfc6979 nonces(_priv, _hash);
+
+  for (;;)
+  {
+    const sc k         = nonces.next();
+    const jcbn_crv_p R = fixed_base_mul(k);
+
+    // r = X / Z^2 mod n, the only field inversion
+    const fe zi  = fe_inv(R.z);
+    const fe zi2 = fe_sqr(zi);
+    const fe x   = fe_mul(R.x, zi2);
+    const sc r   = sc_from_fe(x);
+    if (sc_is_zero(r)) [[unlikely]]
+    {
+      continue;
+    }
+
+    std::uint8_t recid = _recid ? detail::ecdsa_recid({x, fe_mul(R.y, fe_mul(zi2, zi))}) : 0;
+
+    const sc s = detail::ecdsa_s(sc_inv(k), z, r, _priv, recid);
+    if (sc_is_zero(s)) [[unlikely]]
+    {
+      continue;
+    }
+
+    if (_recid)
+    {
+      *_recid = recid;
+    }
+    return {r, s};
+  }
+}
+
+/* same signatures as ecdsa_sign on every entry, one fe and one sc inversion for the whole batch */
+inline void
+ecdsa_sign_batch(std::span<const sc> _priv, std::span<const sha256_digest> _hashes, std::span<ecdsa_sig> _out,
+                 std::span<std::uint8_t> _recids = {})
+{
+  assert(_priv.size() == _hashes.size() && _hashes.size() == _out.size());
+  assert(_recids.empty() || _recids.size() == _out.size());
+
+  const std::size_t n = _priv.size();
+
+  std::vector<std::array<std::uint64_t, 4>> k(n);
+  std::vector<sc> kinv(n);
+  std::vector<crv_p> R(n);
+
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    kinv[i] = rfc6979(_priv[i], _hashes[i].data()).next();
+    k[i]    = {kinv[i].n[0], kinv[i].n[1], kinv[i].n[2], kinv[i].n[3]};
+  }
+
+  fixed_base_mul_many(k, R);
+  sc_batch_inv(kinv);
+
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    sc z;
+    sc_from_bytes(z, _hashes[i].data());
+
+    const sc r         = sc_from_fe(R[i].x);
+    std::uint8_t recid = detail::ecdsa_recid(R[i]);
+    const sc s         = detail::ecdsa_s(kinv[i], z, r, _priv[i], recid);
+
+    // r or s of 0 means the next nonce, ecdsa_sign walks the same sequence
+    if (sc_is_zero(r) || sc_is_zero(s)) [[unlikely]]
+    {
+      _out[i] = ecdsa_sign(_priv[i], _hashes[i].data(), &recid);
+    }
+    else
+    {
+      _out[i] = {r, s};
+    }
+
+    if (!_recids.empty())
+    {
+      _recids[i] = recid;
+    }
+  }
+
+  secure_wipe(k.data(), k.size() * sizeof(k[0]));
+  secure_wipe(kinv.data(), kinv.size() * sizeof(kinv[0]));
+}
+
+namespace detail
+{
+
+/* x(_R) mod n == _r without leaving jacobian: r Z^2 == X, or (r + n) Z^2 == X when r + n < p */
+inline bool
+ecdsa_x_matches(const jcbn_crv_p& _R, const sc& _r) noexcept
+{
+  // p - n
+  static constexpr std::uint64_t p_minus_n[4] = {0x402DA1722FC9BAEEull, 0x4551231950B75FC4ull, 1, 0};
+
+  const fe zz = fe_sqr(_R.z);
+  const fe r  = {{_r.n[0], _r.n[1], _r.n[2], _r.n[3]}};
+
+  if (fe_mul(r, zz) == _R.x)
+  {
+    return true;
+  }
+
+  for (std::size_t i = 4; i-- != 0;)
+  {
+    if (_r.n[i] != p_minus_n[i])
+    {
+      if (_r.n[i] > p_minus_n[i])
+      {
+        return false;
+      }
+      break;
+    }
+  }
+  return fe_mul(fe_add(r, fe{{sc_n.n[0], sc_n.n[1], sc_n.n[2], sc_n.n[3]}}), zz) == _R.x;
+}
+
+} // namespace detail
+
+/*
+  u1 G + u2 Q as one joint multiply (double_base_mul), then r is checked projectively so the
+  result never gets converted to affine. _pub must be a valid point
+*/
+inline bool
+ecdsa_verify(const crv_p& _pub, const std::byte* _hash, const ecdsa_sig& _sig)
+{
+  if (sc_is_zero(_sig.r) || sc_is_zero(_sig.s))
+  {
+    return false;
+  }
+
+  sc z;
+  sc_from_bytes(z, _hash);
+
+  const sc w         = sc_inv(_sig.s);
+  const jcbn_crv_p R = double_base_mul(sc_mul(z, w), _pub, sc_mul(_sig.r, w));
+
+  return !is_identity(R) && detail::ecdsa_x_matches(R, _sig.r);
+}
+
+/* the nonce point R from r and its recovery id, false if there is no such point */
+inline bool
+ecdsa_lift_r(crv_p& _R, const sc& _r, std::uint8_t _recid) noexcept
+{
+  fe x = {{_r.n[0], _r.n[1], _r.n[2], _r.n[3]}};
+
+  if (_recid & 2)
+  {
+    // x = r + n, only valid if that is still below p (if fe_add wrapped, xn mod n isn't r)
+    const fe xn = fe_add(x, fe{{sc_n.n[0], sc_n.n[1], sc_n.n[2], sc_n.n[3]}});
+    if (sc_from_fe(xn) != _r)
+    {
+      return false;
+    }
+    x = xn;
+  }
+  return lift_x(_R, x, _recid & 1);
+}
+
+/*
+  public key recovery, Q = r^-1 (s R - z G) = (-z r^-1) G + (s r^-1) R as one double_base_mul.
+  false if R doesn't lift or Q comes out as O
+*/
+inline bool
+ecdsa_recover(crv_p& _pub, const std::byte* _hash, const ecdsa_sig& _sig, std::uint8_t _recid)
+{
+  crv_p R;
+  if (sc_is_zero(_sig.r) || sc_is_zero(_sig.s) || !ecdsa_lift_r(R, _sig.r, _recid))
+  {
+    return false;
+  }
+
+  sc z;
+  sc_from_bytes(z, _hash);
+
+  const sc w         = sc_inv(_sig.r);
+  const jcbn_crv_p Q = double_base_mul(sc_neg(sc_mul(z, w)), R, sc_mul(_sig.s, w));
+  if (is_identity(Q))
+  {
+    return false;
+  }
+
+  _pub = from_jacobian(Q);
+  return true;
+}
+
+/*
+  ecdsa_recover over a batch: all r^-1 from one sc_batch_inv, the joint multiplies stay
+  jacobian and one batch_from_jacobian normalizes the lot. _valid gets 1 / 0 per entry
+  (_pubs is left at O for the failed ones), returns true if all of them recovered
+*/
+inline bool
+ecdsa_recover_batch(std::span<const sha256_digest> _hashes, std::span<const ecdsa_sig> _sigs, std::span<const std::uint8_t> _recids,
+                    std::span<crv_p> _pubs, std::span<std::uint8_t> _valid)
+{
+  const std::size_t n = _sigs.size();
+  assert(_hashes.size() == n && _recids.size() == n && _pubs.size() == n && _valid.size() == n);
+
+  std::vector<sc> w(n);
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    w[i] = _sigs[i].r;
+  }
+  sc_batch_inv(w);
+
+  std::vector<jcbn_crv_p> Q(n, j_identity_element);
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    crv_p R;
+    if (sc_is_zero(_sigs[i].r) || sc_is_zero(_sigs[i].s) || !ecdsa_lift_r(R, _sigs[i].r, _recids[i]))
+    {
+      continue;
+    }
+
+    sc z;
+    sc_from_bytes(z, _hashes[i].data());
+    Q[i] = double_base_mul(sc_neg(sc_mul(z, w[i])), R, sc_mul(_sigs[i].s, w[i]));
+  }
+
+  batch_from_jacobian(Q, _pubs);
+
+  bool all = true;
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    _valid[i] = !is_identity(Q[i]);
+    all &= _valid[i] != 0;
+  }
+  return all;
+}
+
+/* below this many signatures the bisection just verifies one by one */
+static constexpr std::size_t ecdsa_batch_leaf = 4;
+
+/*
+  randomized batch verify with the R hints from signing (_recids). every signature says
+  s_i R_i = z_i G + r_i Q_i, so with random 128 bit weights a_i
+      (sum a_i u1_i) G + sum (a_i u2_i) Q_i - sum a_i R_i = O
+  is one msm over 2n + 1 points, and a bad signature breaks it with probability 1 - 2^-128.
+  all the s^-1 come from one sc_batch_inv. if the sum isn't O the range is split in halves
+  until the bad ones are found, leaves go through ecdsa_verify (which doesn't need the hint).
+  _valid gets 1 / 0 per signature, returns true if all of them passed.
+*/
+inline bool
+ecdsa_verify_batch(std::span<const crv_p> _pubs, std::span<const sha256_digest> _hashes, std::span<const ecdsa_sig> _sigs,
+                   std::span<const std::uint8_t> _recids, std::span<std::uint8_t> _valid)
+{
+  const std::size_t n = _sigs.size();
+  assert(_pubs.size() == n && _hashes.size() == n && _recids.size() == n && _valid.size() == n);
+
+  std::vector<sc> u1(n), u2(n), a(n);
+  std::vector<crv_p> R(n);
+  std::vector<std::uint8_t> usable(n);
+
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    u1[i] = _sigs[i].s;
+  }
+  sc_batch_inv(u1);
+
+  chacha_drbg& rng = chacha_drbg::local();
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    const sc w = u1[i];
+    sc z;
+    sc_from_bytes(z, _hashes[i].data());
+
+    u1[i]     = sc_mul(z, w);
+    u2[i]     = sc_mul(_sigs[i].r, w);
+    usable[i] = !sc_is_zero(_sigs[i].r) && !sc_is_zero(_sigs[i].s) && ecdsa_lift_r(R[i], _sigs[i].r, _recids[i]);
+
+    do
+    {
+      a[i] = {{rng.next_u64(), rng.next_u64(), 0, 0}};
+    } while (sc_is_zero(a[i]));
+  }
+
+  std::vector<crv_p> points;
+  std::vector<sc> scalars;
+
+  const auto batch_ok = [&](std::size_t _lo, std::size_t _hi)
+  {
+    points.clear();
+    scalars.clear();
+
+    sc g = sc_zero;
+    for (std::size_t i = _lo; i != _hi; ++i)
+    {
+      if (!usable[i])
+      {
+        return false;
+      }
+
+      g = sc_add(g, sc_mul(a[i], u1[i]));
+      points.push_back(_pubs[i]);
+      scalars.push_back(sc_mul(a[i], u2[i]));
+      points.push_back(R[i]);
+      scalars.push_back(sc_neg(a[i]));
+    }
+    points.push_back(G);
+    scalars.push_back(g);
+
+    return is_identity(msm(points, scalars));
+  };
+
+  const auto check = [&](const auto& _self, std::size_t _lo, std::size_t _hi) -> void
+  {
+    if (_hi - _lo <= ecdsa_batch_leaf)
+    {
+      for (std::size_t i = _lo; i != _hi; ++i)
+      {
+        _valid[i] = ecdsa_verify(_pubs[i], _hashes[i].data(), _sigs[i]);
+      }
+      return;
+    }
+
+    if (batch_ok(_lo, _hi))
+    {
+      std::fill(_valid.begin() + _lo, _valid.begin() + _hi, 1);
+      return;
+    }
+
+    const std::size_t mid = _lo + (_hi - _lo) / 2;
+    _self(_self, _lo, mid);
+    _self(_self, mid, _hi);
+  };
+
+  check(check, 0, n);
+  return std::all_of(_valid.begin(), _valid.end(), [](std::uint8_t v) { return v != 0; });
+}
+
+} // namespace blue_crypto::secp256k1
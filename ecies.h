@@ -0,0 +1,364 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "chacha20_poly1305.h"
+#include "curve_batch.h"
+#include "ecdh.h"
+#include "keygen.h"
+#include "sec1.h"
+#include "sha256.h"
+
+/*
+  ECIES on secp256k1 with ChaCha20-Poly1305:
+
+    sender    : ephemeral e, E = e G, x = x(e R) for the recipient key R
+    keys      : HKDF-SHA256(ikm = x, salt = compressed E, info = ecies_info) -> 32 byte key || 12 byte nonce
+    ciphertext: compressed E (33) || ChaCha20-Poly1305(key, nonce, aad, plaintext) || tag (16)
+
+  every message has its own ephemeral key, so the derived nonce never repeats under a key.
+  e R and d E both go through the sc ecdh_x, which is constant time in e and d.
+  the encryptor / decryptor objects stream the payload in chunks of any size. the batch calls
+  share the curve work: ecies_encrypt_many runs the ephemeral keys through fixed_base_mul_many
+  and the shared x through ecdh_x_many, ecies_decrypt_many (one recipient, many messages)
+  decodes every E with sec1_decode_many and multiplies them all by the private key with
+  fixed_scalar_mul_many.
+*/
+
+namespace blue_crypto::secp256k1
+{
+
+static constexpr std::size_t ecies_header_size = sec1_compressed_size;
+static constexpr std::size_t ecies_overhead    = ecies_header_size + poly1305_tag_size;
+
+static constexpr std::string_view ecies_info = "blue_crypto ecies secp256k1 chacha20-poly1305";
+
+namespace detail
+{
+
+struct ecies_keys
+{
+  std::array<std::byte, chacha20_key_size + chacha20_nonce_size> okm;
+
+  ~ecies_keys() { secure_wipe(okm.data(), okm.size()); }
+
+  std::span<const std::byte, chacha20_key_size>
+  key() const noexcept
+  {
+    return std::span{okm}.first<chacha20_key_size>();
+  }
+
+  std::span<const std::byte, chacha20_nonce_size>
+  nonce() const noexcept
+  {
+    return std::span{okm}.last<chacha20_nonce_size>();
+  }
+};
+
+/* the key schedule from the shared x and the compressed ephemeral key */
+inline void
+ecies_derive(ecies_keys& _out, const fe& _x, const std::byte* _header) noexcept
+{
+  std::byte ikm[ecdh_x_size];
+  fe_to_bytes(_x, ikm);
+  hkdf_sha256(_out.okm, ikm, {_header, ecies_header_size}, std::as_bytes(std::span{ecies_info}));
+  secure_wipe(ikm, sizeof(ikm));
+}
+
+inline sc
+sc_from_limbs(const std::array<std::uint64_t, 4>& _k) noexcept
+{
+  sc out;
+  std::copy(_k.begin(), _k.end(), out.n);
+  return out;
+}
+
+} // namespace detail
+
+/*
+  encrypting side of one message: header() goes out first, then update() over the payload
+  chunks and the tag from finalize() last. valid() is false if _recipient is O (or not usable
+  as a key in some other way), nothing may be sent then
+*/
+class ecies_encryptor
+{
+public:
+  template <class Rng>
+  ecies_encryptor(Rng& _rng, const crv_p& _recipient, std::span<const std::byte> _aad = {})
+  {
+    if (_recipient == a_identity_element)
+    {
+      return;
+    }
+
+    std::array<std::uint64_t, 4> k = random_scalar(_rng);
+    sc e                           = detail::sc_from_limbs(k);
+    secure_wipe(k.data(), sizeof(k));
+
+    fe x;
+    if (!ecdh_x(x, precompute(to_jacobian(_recipient)), e))
+    {
+      secure_wipe(&e, sizeof(e));
+      return;
+    }
+    to_compressed(from_jacobian(fixed_base_mul(e)), header_.data());
+    secure_wipe(&e, sizeof(e));
+
+    detail::ecies_keys keys;
+    detail::ecies_derive(keys, x, header_.data());
+    aead_.emplace(keys.key(), keys.nonce(), _aad);
+
+    secure_wipe(&x, sizeof(x));
+  }
+
+  bool
+  valid() const noexcept
+  {
+    return aead_.has_value();
+  }
+
+  std::span<const std::byte, ecies_header_size>
+  header() const noexcept
+  {
+    return header_;
+  }
+
+  /* _in and _out may be the same buffer */
+  void
+  update(std::span<const std::byte> _in, std::span<std::byte> _out) noexcept
+  {
+    assert(valid());
+    aead_->encrypt(_in, _out);
+  }
+
+  poly1305_tag
+  finalize() noexcept
+  {
+    assert(valid());
+    return aead_->finalize();
+  }
+
+private:
+  std::array<std::byte, ecies_header_size> header_{};
+  std::optional<chacha20_poly1305> aead_;
+};
+
+/*
+  decrypting side: the 33 byte header, then update() over the ciphertext chunks and verify()
+  with the trailing tag. update() returns plaintext before it has been authenticated, nothing
+  may act on it until verify() returned true. valid() is false for a header that isn't a point
+*/
+class ecies_decryptor
+{
+public:
+  ecies_decryptor(const sc& _priv, std::span<const std::byte, ecies_header_size> _header, std::span<const std::byte> _aad = {})
+  {
+    crv_p E;
+    fe x;
+    if (!sec1_decode(E, _header) || !ecdh_x(x, precompute(to_jacobian(E)), _priv))
+    {
+      return;
+    }
+
+    detail::ecies_keys keys;
+    detail::ecies_derive(keys, x, _header.data());
+    aead_.emplace(keys.key(), keys.nonce(), _aad);
+
+    secure_wipe(&x, sizeof(x));
+  }
+
+  bool
+  valid() const noexcept
+  {
+    return aead_.has_value();
+  }
+
+  void
+  update(std::span<const std::byte> _in, std::span<std::byte> _out) noexcept
+  {
+    assert(valid());
+    aead_->decrypt(_in, _out);
+  }
+
+  bool
+  verify(std::span<const std::byte, poly1305_tag_size> _tag) noexcept
+  {
+    return valid() && aead_->verify(_tag);
+  }
+
+private:
+  std::optional<chacha20_poly1305> aead_;
+};
+
+/* _out is _pt.size() + ecies_overhead bytes. false if _recipient isn't a usable key */
+template <class Rng>
+inline bool
+ecies_encrypt(Rng& _rng, const crv_p& _recipient, std::span<const std::byte> _pt, std::span<std::byte> _out,
+              std::span<const std::byte> _aad = {})
+{
+  assert(_out.size() == _pt.size() + ecies_overhead);
+
+  ecies_encryptor enc{_rng, _recipient, _aad};
+  if (!enc.valid())
+  {
+    return false;
+  }
+
+  std::copy(enc.header().begin(), enc.header().end(), _out.begin());
+  enc.update(_pt, _out.subspan(ecies_header_size, _pt.size()));
+  const poly1305_tag tag = enc.finalize();
+  std::copy(tag.begin(), tag.end(), _out.last<poly1305_tag_size>().begin());
+  return true;
+}
+
+/* _pt is _ct.size() - ecies_overhead bytes. false (and _pt wiped) for a bad header or tag */
+inline bool
+ecies_decrypt(const sc& _priv, std::span<const std::byte> _ct, std::span<std::byte> _pt, std::span<const std::byte> _aad = {})
+{
+  assert(_ct.size() == _pt.size() + ecies_overhead);
+
+  ecies_decryptor dec{_priv, _ct.first<ecies_header_size>(), _aad};
+  if (!dec.valid())
+  {
+    return false;
+  }
+
+  dec.update(_ct.subspan(ecies_header_size, _pt.size()), _pt);
+  if (!dec.verify(_ct.last<poly1305_tag_size>()))
+  {
+    secure_wipe(_pt.data(), _pt.size());
+    return false;
+  }
+  return true;
+}
+
+/*
+  many small messages, each to its own recipient: _outs[i] is _msgs[i].size() + ecies_overhead
+  bytes. the ephemeral public keys come out of one fixed_base_mul_many and the shared x of
+  one constant time ecdh_x_many (shared inversions). _ok gets 0 for recipients that are O,
+  returns true if everything was encrypted
+*/
+template <class Rng>
+inline bool
+ecies_encrypt_many(Rng& _rng, std::span<const crv_p> _recipients, std::span<const std::span<const std::byte>> _msgs,
+                   std::span<const std::span<std::byte>> _outs, std::span<std::uint8_t> _ok, std::span<const std::byte> _aad = {})
+{
+  const std::size_t n = _recipients.size();
+  assert(_msgs.size() == n && _outs.size() == n && _ok.size() == n);
+
+  std::vector<std::array<std::uint64_t, 4>> k(n);
+  std::vector<sc> nums(n);
+  std::vector<std::vector<jcbn_crv_p>> tables(n);
+  std::vector<const std::vector<jcbn_crv_p>*> table_ptrs(n);
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    k[i]    = random_scalar(_rng);
+    nums[i] = detail::sc_from_limbs(k[i]);
+    // O has no table, G stands in and the result is dropped below
+    tables[i]     = precompute(to_jacobian(_recipients[i] == a_identity_element ? G : _recipients[i]));
+    table_ptrs[i] = &tables[i];
+  }
+
+  std::vector<crv_p> E(n);
+  fixed_base_mul_many(k, E);
+  secure_wipe(k.data(), k.size() * sizeof(k[0]));
+
+  std::vector<fe> xs(n);
+  ecdh_x_many(table_ptrs, nums, xs, _ok);
+  secure_wipe(nums.data(), nums.size() * sizeof(sc));
+
+  bool all = true;
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    assert(_outs[i].size() == _msgs[i].size() + ecies_overhead);
+
+    _ok[i] &= _recipients[i] != a_identity_element;
+    if (!_ok[i])
+    {
+      all = false;
+      continue;
+    }
+
+    const std::span<std::byte> out = _outs[i];
+    to_compressed(E[i], out.data());
+
+    detail::ecies_keys keys;
+    detail::ecies_derive(keys, xs[i], out.data());
+
+    chacha20_poly1305 aead{keys.key(), keys.nonce(), _aad};
+    aead.encrypt(_msgs[i], out.subspan(ecies_header_size, _msgs[i].size()));
+    const poly1305_tag tag = aead.finalize();
+    std::copy(tag.begin(), tag.end(), out.last<poly1305_tag_size>().begin());
+  }
+
+  secure_wipe(xs.data(), xs.size() * sizeof(fe));
+  return all;
+}
+
+/*
+  many messages to one recipient: _pts[i] is _cts[i].size() - ecies_overhead bytes. all the
+  ephemeral keys are decoded together (batched square roots) and multiplied by _priv in one
+  fixed_scalar_mul_many. _ok gets 0 for a bad header or tag (that _pts[i] is wiped), returns
+  true if everything decrypted
+*/
+inline bool
+ecies_decrypt_many(const sc& _priv, std::span<const std::span<const std::byte>> _cts, std::span<const std::span<std::byte>> _pts,
+                   std::span<std::uint8_t> _ok, std::span<const std::byte> _aad = {})
+{
+  const std::size_t n = _cts.size();
+  assert(_pts.size() == n && _ok.size() == n);
+
+  std::vector<std::byte> headers(n * ecies_header_size);
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    assert(_cts[i].size() == _pts[i].size() + ecies_overhead);
+    std::copy_n(_cts[i].data(), ecies_header_size, &headers[i * ecies_header_size]);
+  }
+
+  std::vector<crv_p> E(n);
+  sec1_decode_many(headers, E, _ok);
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    // undecodable ones multiply G instead and are dropped below
+    if (!_ok[i])
+    {
+      E[i] = G;
+    }
+  }
+
+  std::vector<crv_p> S(n);
+  fixed_scalar_mul_many(make_scalar_plan(_priv), E, S);
+
+  bool all = true;
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    _ok[i] &= S[i] != a_identity_element;
+    if (_ok[i])
+    {
+      detail::ecies_keys keys;
+      detail::ecies_derive(keys, S[i].x, &headers[i * ecies_header_size]);
+
+      chacha20_poly1305 aead{keys.key(), keys.nonce(), _aad};
+      aead.decrypt(_cts[i].subspan(ecies_header_size, _pts[i].size()), _pts[i]);
+      _ok[i] = aead.verify(_cts[i].last<poly1305_tag_size>());
+    }
+
+    if (!_ok[i])
+    {
+      secure_wipe(_pts[i].data(), _pts[i].size());
+      all = false;
+    }
+  }
+
+  secure_wipe(S.data(), S.size() * sizeof(crv_p));
+  return all;
+}
+
+} // namespace blue_crypto::secp256k1
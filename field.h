@@ -0,0 +1,718 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "crypto.h"
+
+/*
+  fixed width arithmetic in the secp256k1 base field, p = 2^256 - 2^32 - 977
+
+  elements are 4 little endian 64 bit limbs and are always kept fully reduced (< p).
+  the 256x256 -> 512 bit multiply and square have two kernels:
+    - mulx/adcx/adox inline asm (needs BMI2 + ADX)
+    - portable unsigned __int128 schoolbook
+  the kernel is picked once at startup via cpuid so we dont need -march=native anymore.
+  the 512 -> 256 bit reduction is shared, it just folds the top half back in using
+  2^256 = 2^32 + 977 (mod p).
+*/
+
+namespace blue_crypto
+{
+
+__extension__ typedef unsigned __int128 u128;
+
+struct fe
+{
+  std::uint64_t n[4];
+
+  bool
+  operator==(const fe& other) const
+  {
+    return ((n[0] ^ other.n[0]) | (n[1] ^ other.n[1]) | (n[2] ^ other.n[2]) | (n[3] ^ other.n[3])) == 0;
+  }
+
+  bool
+  operator!=(const fe& other) const
+  {
+    return !(this->operator==(other));
+  }
+};
+
+static constexpr fe fe_p       = {{0xFFFFFFFEFFFFFC2Full, 0xFFFFFFFFFFFFFFFFull, 0xFFFFFFFFFFFFFFFFull, 0xFFFFFFFFFFFFFFFFull}};
+static constexpr fe fe_zero    = {{0, 0, 0, 0}};
+static constexpr fe fe_one     = {{1, 0, 0, 0}};
+static constexpr std::uint64_t fe_c = 0x1000003D1ull; // 2^256 mod p
+
+namespace detail
+{
+
+/* t is a full 512 bit product, out is fully reduced */
+inline void
+fe_reduce_512(std::uint64_t* out, const std::uint64_t* t) noexcept
+{
+  std::uint64_t r[4];
+  u128 acc = 0;
+
+  // r = lo + hi * c, the top word ends up <= 2^34
+  for (int i = 0; i != 4; ++i)
+  {
+    acc += (u128)t[i + 4] * fe_c + t[i];
+    r[i] = (std::uint64_t)acc;
+    acc >>= 64;
+  }
+
+  // fold the top word again, top * c < 2^67
+  acc = (u128)((std::uint64_t)acc) * fe_c + r[0];
+  r[0] = (std::uint64_t)acc;
+  acc >>= 64;
+  for (int i = 1; i != 4; ++i)
+  {
+    acc += r[i];
+    r[i] = (std::uint64_t)acc;
+    acc >>= 64;
+  }
+
+  // if that wrapped we are left with something tiny, adding c once more cant carry out
+  const std::uint64_t wrapped = (std::uint64_t)acc;
+  acc = (u128)r[0] + (fe_c & (0 - wrapped));
+  r[0] = (std::uint64_t)acc;
+  acc >>= 64;
+  for (int i = 1; i != 4; ++i)
+  {
+    acc += r[i];
+    r[i] = (std::uint64_t)acc;
+    acc >>= 64;
+  }
+
+  // final conditional subtract: r >= p <=> r + c >= 2^256
+  std::uint64_t s[4];
+  acc = (u128)r[0] + fe_c;
+  s[0] = (std::uint64_t)acc;
+  acc >>= 64;
+  for (int i = 1; i != 4; ++i)
+  {
+    acc += r[i];
+    s[i] = (std::uint64_t)acc;
+    acc >>= 64;
+  }
+
+  const std::uint64_t mask = 0 - (std::uint64_t)acc;
+  for (int i = 0; i != 4; ++i)
+  {
+    out[i] = (s[i] & mask) | (r[i] & ~mask);
+  }
+}
+
+inline void
+mul_512_portable(std::uint64_t* t, const std::uint64_t* a, const std::uint64_t* b) noexcept
+{
+  std::uint64_t lo[8]{};
+
+  for (int i = 0; i != 4; ++i)
+  {
+    u128 carry = 0;
+    for (int j = 0; j != 4; ++j)
+    {
+      carry += (u128)a[i] * b[j] + lo[i + j];
+      lo[i + j] = (std::uint64_t)carry;
+      carry >>= 64;
+    }
+    lo[i + 4] = (std::uint64_t)carry;
+  }
+
+  std::memcpy(t, lo, sizeof(lo));
+}
+
+inline void
+sqr_512_portable(std::uint64_t* t, const std::uint64_t* a) noexcept
+{
+  std::uint64_t lo[8]{};
+
+  // off diagonal terms once
+  for (int i = 0; i != 3; ++i)
+  {
+    u128 carry = 0;
+    for (int j = i + 1; j != 4; ++j)
+    {
+      carry += (u128)a[i] * a[j] + lo[i + j];
+      lo[i + j] = (std::uint64_t)carry;
+      carry >>= 64;
+    }
+    lo[i + 4] = (std::uint64_t)carry;
+  }
+
+  // double them and add the squares
+  std::uint64_t top = 0;
+  for (int i = 0; i != 8; ++i)
+  {
+    const std::uint64_t next = lo[i] >> 63;
+    lo[i]                    = (lo[i] << 1) | top;
+    top                      = next;
+  }
+
+  u128 carry = 0;
+  for (int i = 0; i != 4; ++i)
+  {
+    const u128 sq = (u128)a[i] * a[i];
+    carry += (u128)lo[2 * i] + (std::uint64_t)sq;
+    lo[2 * i] = (std::uint64_t)carry;
+    carry >>= 64;
+    carry += (u128)lo[2 * i + 1] + (std::uint64_t)(sq >> 64);
+    lo[2 * i + 1] = (std::uint64_t)carry;
+    carry >>= 64;
+  }
+
+  std::memcpy(t, lo, sizeof(lo));
+}
+
+#if defined(__x86_64__)
+
+/*
+  row by row product scanning, rdx holds b[i], the low halves of each partial product
+  go through the CF chain (adcx) and the high halves through the OF chain (adox)
+  so both carry chains run interleaved without any flag spills.
+*/
+inline void
+mul_512_adx(std::uint64_t* t, const std::uint64_t* a, const std::uint64_t* b) noexcept
+{
+  __asm__ volatile(
+      // row 0
+      "movq 0(%[b]), %%rdx\n\t"
+      "mulxq 0(%[a]), %%r8, %%r9\n\t"
+      "mulxq 8(%[a]), %%rax, %%r10\n\t"
+      "addq %%rax, %%r9\n\t"
+      "mulxq 16(%[a]), %%rax, %%r11\n\t"
+      "adcq %%rax, %%r10\n\t"
+      "mulxq 24(%[a]), %%rax, %%r12\n\t"
+      "adcq %%rax, %%r11\n\t"
+      "adcq $0, %%r12\n\t"
+      "movq %%r8, 0(%[t])\n\t"
+
+      // row 1
+      "movq 8(%[b]), %%rdx\n\t"
+      "xorl %%r13d, %%r13d\n\t"
+      "mulxq 0(%[a]), %%rax, %%rbx\n\t"
+      "adcxq %%rax, %%r9\n\t"
+      "adoxq %%rbx, %%r10\n\t"
+      "mulxq 8(%[a]), %%rax, %%rbx\n\t"
+      "adcxq %%rax, %%r10\n\t"
+      "adoxq %%rbx, %%r11\n\t"
+      "mulxq 16(%[a]), %%rax, %%rbx\n\t"
+      "adcxq %%rax, %%r11\n\t"
+      "adoxq %%rbx, %%r12\n\t"
+      "mulxq 24(%[a]), %%rax, %%rbx\n\t"
+      "adcxq %%rax, %%r12\n\t"
+      "adoxq %%rbx, %%r13\n\t"
+      "adcq $0, %%r13\n\t"
+      "movq %%r9, 8(%[t])\n\t"
+
+      // row 2
+      "movq 16(%[b]), %%rdx\n\t"
+      "xorl %%r8d, %%r8d\n\t"
+      "mulxq 0(%[a]), %%rax, %%rbx\n\t"
+      "adcxq %%rax, %%r10\n\t"
+      "adoxq %%rbx, %%r11\n\t"
+      "mulxq 8(%[a]), %%rax, %%rbx\n\t"
+      "adcxq %%rax, %%r11\n\t"
+      "adoxq %%rbx, %%r12\n\t"
+      "mulxq 16(%[a]), %%rax, %%rbx\n\t"
+      "adcxq %%rax, %%r12\n\t"
+      "adoxq %%rbx, %%r13\n\t"
+      "mulxq 24(%[a]), %%rax, %%rbx\n\t"
+      "adcxq %%rax, %%r13\n\t"
+      "adoxq %%rbx, %%r8\n\t"
+      "adcq $0, %%r8\n\t"
+      "movq %%r10, 16(%[t])\n\t"
+
+      // row 3
+      "movq 24(%[b]), %%rdx\n\t"
+      "xorl %%r9d, %%r9d\n\t"
+      "mulxq 0(%[a]), %%rax, %%rbx\n\t"
+      "adcxq %%rax, %%r11\n\t"
+      "adoxq %%rbx, %%r12\n\t"
+      "mulxq 8(%[a]), %%rax, %%rbx\n\t"
+      "adcxq %%rax, %%r12\n\t"
+      "adoxq %%rbx, %%r13\n\t"
+      "mulxq 16(%[a]), %%rax, %%rbx\n\t"
+      "adcxq %%rax, %%r13\n\t"
+      "adoxq %%rbx, %%r8\n\t"
+      "mulxq 24(%[a]), %%rax, %%rbx\n\t"
+      "adcxq %%rax, %%r8\n\t"
+      "adoxq %%rbx, %%r9\n\t"
+      "adcq $0, %%r9\n\t"
+      "movq %%r11, 24(%[t])\n\t"
+      "movq %%r12, 32(%[t])\n\t"
+      "movq %%r13, 40(%[t])\n\t"
+      "movq %%r8, 48(%[t])\n\t"
+      "movq %%r9, 56(%[t])\n\t"
+      :
+      : [t] "r"(t), [a] "r"(a), [b] "r"(b)
+      : "rax", "rbx", "rdx", "r8", "r9", "r10", "r11", "r12", "r13", "cc", "memory");
+}
+
+/*
+  off diagonal products first (6 mulx), then one pass that doubles on the CF chain
+  and adds the diagonal squares on the OF chain.
+*/
+inline void
+sqr_512_adx(std::uint64_t* t, const std::uint64_t* a) noexcept
+{
+  __asm__ volatile(
+      // a0 * (a1, a2, a3) -> r9..r12
+      "movq 0(%[a]), %%rdx\n\t"
+      "mulxq 8(%[a]), %%r9, %%r10\n\t"
+      "mulxq 16(%[a]), %%rax, %%r11\n\t"
+      "addq %%rax, %%r10\n\t"
+      "mulxq 24(%[a]), %%rax, %%r12\n\t"
+      "adcq %%rax, %%r11\n\t"
+      "adcq $0, %%r12\n\t"
+
+      // a1 * (a2, a3) -> r11..r13
+      "movq 8(%[a]), %%rdx\n\t"
+      "xorl %%r13d, %%r13d\n\t"
+      "mulxq 16(%[a]), %%rax, %%rbx\n\t"
+      "adcxq %%rax, %%r11\n\t"
+      "adoxq %%rbx, %%r12\n\t"
+      "mulxq 24(%[a]), %%rax, %%rbx\n\t"
+      "adcxq %%rax, %%r12\n\t"
+      "adoxq %%rbx, %%r13\n\t"
+      "adcq $0, %%r13\n\t"
+
+      // a2 * a3 -> r13..r14
+      "movq 16(%[a]), %%rdx\n\t"
+      "mulxq 24(%[a]), %%rax, %%r14\n\t"
+      "addq %%rax, %%r13\n\t"
+      "adcq $0, %%r14\n\t"
+
+      // 2 * off diagonal + diagonal
+      "xorl %%r15d, %%r15d\n\t"
+      "movq 0(%[a]), %%rdx\n\t"
+      "mulxq %%rdx, %%r8, %%rax\n\t"
+      "adcxq %%r9, %%r9\n\t"
+      "adoxq %%rax, %%r9\n\t"
+      "movq 8(%[a]), %%rdx\n\t"
+      "mulxq %%rdx, %%rax, %%rbx\n\t"
+      "adcxq %%r10, %%r10\n\t"
+      "adoxq %%rax, %%r10\n\t"
+      "adcxq %%r11, %%r11\n\t"
+      "adoxq %%rbx, %%r11\n\t"
+      "movq 16(%[a]), %%rdx\n\t"
+      "mulxq %%rdx, %%rax, %%rbx\n\t"
+      "adcxq %%r12, %%r12\n\t"
+      "adoxq %%rax, %%r12\n\t"
+      "adcxq %%r13, %%r13\n\t"
+      "adoxq %%rbx, %%r13\n\t"
+      "movq 24(%[a]), %%rdx\n\t"
+      "mulxq %%rdx, %%rax, %%rbx\n\t"
+      "adcxq %%r14, %%r14\n\t"
+      "adoxq %%rax, %%r14\n\t"
+      "adcxq %%r15, %%r15\n\t"
+      "adoxq %%rbx, %%r15\n\t"
+
+      "movq %%r8, 0(%[t])\n\t"
+      "movq %%r9, 8(%[t])\n\t"
+      "movq %%r10, 16(%[t])\n\t"
+      "movq %%r11, 24(%[t])\n\t"
+      "movq %%r12, 32(%[t])\n\t"
+      "movq %%r13, 40(%[t])\n\t"
+      "movq %%r14, 48(%[t])\n\t"
+      "movq %%r15, 56(%[t])\n\t"
+      :
+      : [t] "r"(t), [a] "r"(a)
+      : "rax", "rbx", "rdx", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15", "cc", "memory");
+}
+
+#endif
+
+inline void
+fe_mul_portable(fe& out, const fe& a, const fe& b) noexcept
+{
+  std::uint64_t t[8];
+  mul_512_portable(t, a.n, b.n);
+  fe_reduce_512(out.n, t);
+}
+
+inline void
+fe_sqr_portable(fe& out, const fe& a) noexcept
+{
+  std::uint64_t t[8];
+  sqr_512_portable(t, a.n);
+  fe_reduce_512(out.n, t);
+}
+
+#if defined(__x86_64__)
+
+inline void
+fe_mul_adx(fe& out, const fe& a, const fe& b) noexcept
+{
+  std::uint64_t t[8];
+  mul_512_adx(t, a.n, b.n);
+  fe_reduce_512(out.n, t);
+}
+
+inline void
+fe_sqr_adx(fe& out, const fe& a) noexcept
+{
+  std::uint64_t t[8];
+  sqr_512_adx(t, a.n);
+  fe_reduce_512(out.n, t);
+}
+
+#endif
+
+struct fe_kernels
+{
+  bool adx;
+  const char* name;
+};
+
+inline fe_kernels
+select_fe_kernels() noexcept
+{
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("bmi2") && __builtin_cpu_supports("adx"))
+  {
+    return {true, "mulx/adcx/adox"};
+  }
+#endif
+  return {false, "portable int128"};
+}
+
+} // namespace detail
+
+/*
+  resolved once during static init. a flag instead of a function pointer so both kernels
+  still inline into the point code, the branch is always predicted.
+*/
+inline const detail::fe_kernels fe_kernel = detail::select_fe_kernels();
+
+inline void
+fe_mul(fe& out, const fe& a, const fe& b) noexcept
+{
+#if defined(__x86_64__)
+  if (fe_kernel.adx) [[likely]]
+  {
+    return detail::fe_mul_adx(out, a, b);
+  }
+#endif
+  detail::fe_mul_portable(out, a, b);
+}
+
+inline void
+fe_sqr(fe& out, const fe& a) noexcept
+{
+#if defined(__x86_64__)
+  if (fe_kernel.adx) [[likely]]
+  {
+    return detail::fe_sqr_adx(out, a);
+  }
+#endif
+  detail::fe_sqr_portable(out, a);
+}
+
+[[gnu::pure]] inline fe
+fe_mul(const fe& a, const fe& b) noexcept
+{
+  fe out;
+  fe_mul(out, a, b);
+  return out;
+}
+
+[[gnu::pure]] inline fe
+fe_sqr(const fe& a) noexcept
+{
+  fe out;
+  fe_sqr(out, a);
+  return out;
+}
+
+[[gnu::pure]] inline bool
+fe_is_zero(const fe& a) noexcept
+{
+  return (a.n[0] | a.n[1] | a.n[2] | a.n[3]) == 0;
+}
+
+/* out = b if flag (0 or 1) is set, without a branch on flag */
+inline void
+fe_cmov(fe& out, const fe& b, std::uint64_t flag) noexcept
+{
+  const std::uint64_t mask = 0 - flag;
+  for (int i = 0; i != 4; ++i)
+  {
+    out.n[i] ^= (out.n[i] ^ b.n[i]) & mask;
+  }
+}
+
+[[gnu::pure]] inline fe
+fe_add(const fe& a, const fe& b) noexcept
+{
+  std::uint64_t r[4];
+  u128 acc = 0;
+  for (int i = 0; i != 4; ++i)
+  {
+    acc += (u128)a.n[i] + b.n[i];
+    r[i] = (std::uint64_t)acc;
+    acc >>= 64;
+  }
+
+  // a + b < 2p, subtract p if we carried out or r >= p
+  const std::uint64_t carry = (std::uint64_t)acc;
+  fe s;
+  acc = (u128)r[0] + fe_c;
+  s.n[0] = (std::uint64_t)acc;
+  acc >>= 64;
+  for (int i = 1; i != 4; ++i)
+  {
+    acc += r[i];
+    s.n[i] = (std::uint64_t)acc;
+    acc >>= 64;
+  }
+
+  const std::uint64_t mask = 0 - ((std::uint64_t)acc | carry);
+  fe out;
+  for (int i = 0; i != 4; ++i)
+  {
+    out.n[i] = (s.n[i] & mask) | (r[i] & ~mask);
+  }
+  return out;
+}
+
+[[gnu::pure]] inline fe
+fe_sub(const fe& a, const fe& b) noexcept
+{
+  fe out;
+  std::uint64_t borrow = 0;
+  for (int i = 0; i != 4; ++i)
+  {
+    const u128 d = (u128)a.n[i] - b.n[i] - borrow;
+    out.n[i]     = (std::uint64_t)d;
+    borrow       = (std::uint64_t)(d >> 64) & 1;
+  }
+
+  // went negative, add p back (same as subtracting c mod 2^256)
+  const std::uint64_t mask = 0 - borrow;
+  u128 acc                 = (u128)out.n[0] - (fe_c & mask);
+  out.n[0]                 = (std::uint64_t)acc;
+  borrow                   = (std::uint64_t)(acc >> 64) & 1;
+  for (int i = 1; i != 4; ++i)
+  {
+    acc      = (u128)out.n[i] - borrow;
+    out.n[i] = (std::uint64_t)acc;
+    borrow   = (std::uint64_t)(acc >> 64) & 1;
+  }
+  return out;
+}
+
+[[gnu::pure]] inline fe
+fe_neg(const fe& a) noexcept
+{
+  return fe_sub(fe_zero, a);
+}
+
+[[gnu::pure]] inline fe
+fe_dbl(const fe& a) noexcept
+{
+  return fe_add(a, a);
+}
+
+/* a * small, small < 2^32 */
+[[gnu::pure]] inline fe
+fe_mul_small(const fe& a, std::uint32_t small) noexcept
+{
+  std::uint64_t t[8]{};
+  u128 acc = 0;
+  for (int i = 0; i != 4; ++i)
+  {
+    acc += (u128)a.n[i] * small;
+    t[i] = (std::uint64_t)acc;
+    acc >>= 64;
+  }
+  t[4] = (std::uint64_t)acc;
+
+  fe out;
+  detail::fe_reduce_512(out.n, t);
+  return out;
+}
+
+/* a^(2^n) */
+[[gnu::pure]] inline fe
+fe_sqr_n(fe a, std::size_t n) noexcept
+{
+  while (n--)
+  {
+    fe_sqr(a, a);
+  }
+  return a;
+}
+
+/*
+  fermat inversion a^(p - 2), the usual secp256k1 addition chain
+  (blocks of 1s of length 2, 3, 11, 22, 44, 88, 176, 220, 223), 255 sqr + 15 mul.
+  constant time, 0 maps to 0.
+*/
+[[gnu::pure]] inline fe
+fe_inv(const fe& a) noexcept
+{
+  const fe x2   = fe_mul(fe_sqr(a), a);
+  const fe x3   = fe_mul(fe_sqr(x2), a);
+  const fe x6   = fe_mul(fe_sqr_n(x3, 3), x3);
+  const fe x9   = fe_mul(fe_sqr_n(x6, 3), x3);
+  const fe x11  = fe_mul(fe_sqr_n(x9, 2), x2);
+  const fe x22  = fe_mul(fe_sqr_n(x11, 11), x11);
+  const fe x44  = fe_mul(fe_sqr_n(x22, 22), x22);
+  const fe x88  = fe_mul(fe_sqr_n(x44, 44), x44);
+  const fe x176 = fe_mul(fe_sqr_n(x88, 88), x88);
+  const fe x220 = fe_mul(fe_sqr_n(x176, 44), x44);
+  const fe x223 = fe_mul(fe_sqr_n(x220, 3), x3);
+
+  // p - 2 = [223 ones] 0 [22 ones] 0000 1 0 11 0 1
+  fe t = fe_mul(fe_sqr_n(x223, 23), x22);
+  t    = fe_mul(fe_sqr_n(t, 5), a);
+  t    = fe_mul(fe_sqr_n(t, 3), x2);
+  return fe_mul(fe_sqr_n(t, 2), a);
+}
+
+/*
+  square root for p = 3 mod 4: a^((p+1)/4), same chain as fe_inv up to x223. false (and _out
+  holds garbage) if a isn't a square
+*/
+inline bool
+fe_sqrt(fe& _out, const fe& a) noexcept
+{
+  const fe x2   = fe_mul(fe_sqr(a), a);
+  const fe x3   = fe_mul(fe_sqr(x2), a);
+  const fe x6   = fe_mul(fe_sqr_n(x3, 3), x3);
+  const fe x9   = fe_mul(fe_sqr_n(x6, 3), x3);
+  const fe x11  = fe_mul(fe_sqr_n(x9, 2), x2);
+  const fe x22  = fe_mul(fe_sqr_n(x11, 11), x11);
+  const fe x44  = fe_mul(fe_sqr_n(x22, 22), x22);
+  const fe x88  = fe_mul(fe_sqr_n(x44, 44), x44);
+  const fe x176 = fe_mul(fe_sqr_n(x88, 88), x88);
+  const fe x220 = fe_mul(fe_sqr_n(x176, 44), x44);
+  const fe x223 = fe_mul(fe_sqr_n(x220, 3), x3);
+
+  // (p + 1) / 4 = [223 ones] 0 [22 ones] 0000 11 00
+  fe t = fe_mul(fe_sqr_n(x223, 23), x22);
+  t    = fe_mul(fe_sqr_n(t, 6), x2);
+  _out = fe_sqr_n(t, 2);
+
+  return fe_sqr(_out) == a;
+}
+
+/*
+  montgomery's trick: every element of _v is replaced by its inverse using a single fe_inv
+  and 3 (n - 1) multiplies. zeros are skipped and stay zero. _scratch needs _v.size() slots.
+*/
+inline void
+fe_batch_inv(std::span<fe> _v, std::span<fe> _scratch) noexcept
+{
+  assert(_scratch.size() >= _v.size());
+
+  fe acc = fe_one;
+  for (std::size_t i = 0; i != _v.size(); ++i)
+  {
+    _scratch[i] = acc;
+    if (!fe_is_zero(_v[i])) [[likely]]
+    {
+      fe_mul(acc, acc, _v[i]);
+    }
+  }
+
+  fe inv = fe_inv(acc);
+  for (std::size_t i = _v.size(); i-- != 0;)
+  {
+    if (fe_is_zero(_v[i])) [[unlikely]]
+    {
+      continue;
+    }
+
+    const fe t = fe_mul(inv, _scratch[i]);
+    fe_mul(inv, inv, _v[i]);
+    _v[i] = t;
+  }
+}
+
+inline void
+fe_batch_inv(std::span<fe> _v)
+{
+  std::vector<fe> scratch(_v.size());
+  fe_batch_inv(_v, scratch);
+}
+
+[[gnu::pure]] inline fe
+fe_from_ix(const GmpWrapper& _n)
+{
+  const GmpWrapper r = _n % GmpWrapper{"0xfffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f"};
+  fe out;
+  r.to_limbs(out.n, 4);
+  return out;
+}
+
+[[gnu::pure]] inline GmpWrapper
+fe_to_ix(const fe& _n)
+{
+  return GmpWrapper::from_limbs(_n.n, 4);
+}
+
+namespace detail
+{
+
+/* 4 little endian limbs <-> 32 bytes big endian, the order every wire format uses */
+inline void
+store_be256(const std::uint64_t* _limbs, std::byte* _out) noexcept
+{
+  for (std::size_t i = 0; i != 4; ++i)
+  {
+    const std::uint64_t be = __builtin_bswap64(_limbs[3 - i]);
+    std::memcpy(_out + 8 * i, &be, 8);
+  }
+}
+
+inline void
+load_be256(std::uint64_t* _limbs, const std::byte* _in) noexcept
+{
+  for (std::size_t i = 0; i != 4; ++i)
+  {
+    std::uint64_t be;
+    std::memcpy(&be, _in + 8 * i, 8);
+    _limbs[3 - i] = __builtin_bswap64(be);
+  }
+}
+
+} // namespace detail
+
+inline void
+fe_to_bytes(const fe& _a, std::byte* _out) noexcept
+{
+  detail::store_be256(_a.n, _out);
+}
+
+/* false (and _out untouched) if the 32 bytes are >= p */
+inline bool
+fe_from_bytes(fe& _out, const std::byte* _in) noexcept
+{
+  fe r;
+  detail::load_be256(r.n, _in);
+
+  // compare against p from the top limb down
+  for (std::size_t i = 4; i-- != 0;)
+  {
+    if (r.n[i] != fe_p.n[i])
+    {
+      if (r.n[i] > fe_p.n[i])
+      {
+        return false;
+      }
+      _out = r;
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace blue_crypto
@@ -0,0 +1,578 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <immintrin.h>
+
+#include "field.h"
+
+/*
+  lane parallel secp256k1 field, n independent elements per instruction
+
+    lanes_avx2 : 4 lanes, 10 limbs of 2^26, vpmuludq schoolbook
+    lanes_ifma : 8 lanes, 5 limbs of 2^52, vpmadd52{lo,hi}uq
+
+  limbs are stored limb major (v[limb][lane]) in plain arrays so the types can be passed around
+  by code that isnt compiled for avx, only the kernels below carry target attributes.
+
+  elements are only weakly reduced (< 2^260, limbs normalized), store() does the final reduction.
+  2^260 = 0x1000003D10 (mod p) is used to fold the top half back in.
+*/
+
+namespace blue_crypto
+{
+
+struct alignas(32) fe_x4
+{
+  std::uint64_t v[10][4];
+};
+
+struct alignas(64) fe_x8
+{
+  std::uint64_t v[5][8];
+};
+
+namespace detail
+{
+
+[[gnu::pure]] constexpr std::uint64_t
+fe_get_bits(const fe& _n, std::size_t _pos, std::size_t _width) noexcept
+{
+  const std::size_t word  = _pos / 64;
+  const std::size_t shift = _pos % 64;
+
+  std::uint64_t out = _n.n[word] >> shift;
+  if (shift + _width > 64 && word + 1 != 4)
+  {
+    out |= _n.n[word + 1] << (64 - shift);
+  }
+  return out & ((std::uint64_t{1} << _width) - 1);
+}
+
+/* sum of limbs[i] * 2^(radix * i), limbs may be a bit over radix bits */
+inline fe
+fe_from_radix(const std::uint64_t* _limbs, std::size_t _count, std::size_t _radix) noexcept
+{
+  std::uint64_t t[8]{};
+
+  for (std::size_t i = 0; i != _count; ++i)
+  {
+    const std::size_t pos = i * _radix;
+    std::size_t word      = pos / 64;
+    u128 acc              = (u128)_limbs[i] << (pos % 64);
+
+    while (acc != 0)
+    {
+      acc += t[word];
+      t[word++] = (std::uint64_t)acc;
+      acc >>= 64;
+    }
+  }
+
+  fe out;
+  fe_reduce_512(out.n, t);
+  return out;
+}
+
+static constexpr std::uint64_t x26_mask = (std::uint64_t{1} << 26) - 1;
+static constexpr std::uint64_t x52_mask = (std::uint64_t{1} << 52) - 1;
+static constexpr std::uint64_t x52_r    = 0x1000003D10ull; // 2^260 mod p
+
+/* x * 0x3D10 = x * (2^14 - 2^10 + 2^8 + 2^4), exact for x < 2^50 unlike vpmuludq */
+[[gnu::target("avx2")]] inline __m256i
+x26_mul_r0(__m256i x) noexcept
+{
+  const __m256i t = _mm256_sub_epi64(_mm256_slli_epi64(x, 14), _mm256_slli_epi64(x, 10));
+  return _mm256_add_epi64(t, _mm256_add_epi64(_mm256_slli_epi64(x, 8), _mm256_slli_epi64(x, 4)));
+}
+
+/* d[10] holds weight 2^260, two fold rounds leave every limb <= 26 bits (+ a tiny bit in d[1]) */
+[[gnu::target("avx2")]] inline void
+x26_carry(__m256i* d) noexcept
+{
+  const __m256i mask = _mm256_set1_epi64x(x26_mask);
+
+  for (int i = 0; i != 10; ++i)
+  {
+    d[i + 1] = _mm256_add_epi64(d[i + 1], _mm256_srli_epi64(d[i], 26));
+    d[i]     = _mm256_and_si256(d[i], mask);
+  }
+
+  d[0] = _mm256_add_epi64(d[0], x26_mul_r0(d[10]));
+  d[1] = _mm256_add_epi64(d[1], _mm256_slli_epi64(d[10], 10));
+
+  for (int i = 0; i != 9; ++i)
+  {
+    d[i + 1] = _mm256_add_epi64(d[i + 1], _mm256_srli_epi64(d[i], 26));
+    d[i]     = _mm256_and_si256(d[i], mask);
+  }
+
+  const __m256i top = _mm256_srli_epi64(d[9], 26);
+  d[9]              = _mm256_and_si256(d[9], mask);
+  d[0]              = _mm256_add_epi64(d[0], x26_mul_r0(top));
+  d[1]              = _mm256_add_epi64(d[1], _mm256_slli_epi64(top, 10));
+  d[1]              = _mm256_add_epi64(d[1], _mm256_srli_epi64(d[0], 26));
+  d[0]              = _mm256_and_si256(d[0], mask);
+}
+
+/* 19 product columns -> weakly reduced element */
+[[gnu::target("avx2")]] inline void
+x26_reduce_wide(fe_x4& out, __m256i* c) noexcept
+{
+  const __m256i mask = _mm256_set1_epi64x(x26_mask);
+
+  c[19] = _mm256_setzero_si256();
+  for (int i = 0; i != 19; ++i)
+  {
+    c[i + 1] = _mm256_add_epi64(c[i + 1], _mm256_srli_epi64(c[i], 26));
+    c[i]     = _mm256_and_si256(c[i], mask);
+  }
+
+  // limb k >= 10 is worth limb (k - 10) * (2^36 + 0x3D10)
+  __m256i d[11];
+  for (int i = 0; i != 10; ++i)
+  {
+    d[i] = c[i];
+  }
+  d[10] = _mm256_setzero_si256();
+
+  for (int k = 10; k != 20; ++k)
+  {
+    d[k - 10] = _mm256_add_epi64(d[k - 10], x26_mul_r0(c[k]));
+    d[k - 9]  = _mm256_add_epi64(d[k - 9], _mm256_slli_epi64(c[k], 10));
+  }
+
+  x26_carry(d);
+
+  for (int i = 0; i != 10; ++i)
+  {
+    _mm256_store_si256((__m256i*)out.v[i], d[i]);
+  }
+}
+
+/* same as _mm512_srli_epi64(x, 52), the maskz form keeps gcc 12 from warning about its own header */
+[[gnu::target("avx512f,avx512ifma")]] inline __m512i
+x52_shr(__m512i x) noexcept
+{
+  return _mm512_maskz_srli_epi64((__mmask8)0xFF, x, 52);
+}
+
+[[gnu::target("avx512f,avx512ifma")]] inline void
+x52_carry(__m512i* d) noexcept
+{
+  const __m512i mask = _mm512_set1_epi64(x52_mask);
+  const __m512i r    = _mm512_set1_epi64(x52_r);
+
+  for (int i = 0; i != 5; ++i)
+  {
+    d[i + 1] = _mm512_add_epi64(d[i + 1], x52_shr(d[i]));
+    d[i]     = _mm512_and_si512(d[i], mask);
+  }
+
+  d[0] = _mm512_madd52lo_epu64(d[0], d[5], r);
+  d[1] = _mm512_madd52hi_epu64(d[1], d[5], r);
+
+  for (int i = 0; i != 4; ++i)
+  {
+    d[i + 1] = _mm512_add_epi64(d[i + 1], x52_shr(d[i]));
+    d[i]     = _mm512_and_si512(d[i], mask);
+  }
+
+  const __m512i top = x52_shr(d[4]);
+  d[4]              = _mm512_and_si512(d[4], mask);
+  d[0]              = _mm512_madd52lo_epu64(d[0], top, r);
+  d[1]              = _mm512_add_epi64(d[1], x52_shr(d[0]));
+  d[0]              = _mm512_and_si512(d[0], mask);
+}
+
+[[gnu::target("avx512f,avx512ifma")]] inline void
+x52_reduce_wide(fe_x8& out, __m512i* c) noexcept
+{
+  const __m512i mask = _mm512_set1_epi64(x52_mask);
+  const __m512i r    = _mm512_set1_epi64(x52_r);
+
+  for (int i = 0; i != 9; ++i)
+  {
+    c[i + 1] = _mm512_add_epi64(c[i + 1], x52_shr(c[i]));
+    c[i]     = _mm512_and_si512(c[i], mask);
+  }
+
+  // madd52 only looks at the low 52 bits of its inputs, so read the top half untouched
+  __m512i d[6];
+  for (int i = 0; i != 5; ++i)
+  {
+    d[i] = c[i];
+  }
+  d[5] = _mm512_setzero_si512();
+
+  for (int k = 5; k != 10; ++k)
+  {
+    d[k - 5] = _mm512_madd52lo_epu64(d[k - 5], c[k], r);
+    d[k - 4] = _mm512_madd52hi_epu64(d[k - 4], c[k], r);
+  }
+
+  x52_carry(d);
+
+  for (int i = 0; i != 5; ++i)
+  {
+    _mm512_store_si512((__m512i*)out.v[i], d[i]);
+  }
+}
+
+} // namespace detail
+
+struct lanes_avx2
+{
+  using elem                          = fe_x4;
+  static constexpr std::size_t width  = 4;
+  static constexpr std::size_t limbs  = 10;
+  static constexpr std::size_t radix  = 26;
+  static constexpr const char* name   = "avx2 4x26";
+
+  static void
+  load(elem& _out, const fe* _in) noexcept
+  {
+    for (std::size_t l = 0; l != width; ++l)
+    {
+      put(_out, l, _in[l]);
+    }
+  }
+
+  static void
+  put(elem& _out, std::size_t _lane, const fe& _in) noexcept
+  {
+    for (std::size_t i = 0; i != limbs; ++i)
+    {
+      _out.v[i][_lane] = detail::fe_get_bits(_in, i * radix, radix);
+    }
+  }
+
+  static fe
+  get(const elem& _in, std::size_t _lane) noexcept
+  {
+    std::uint64_t t[limbs];
+    for (std::size_t i = 0; i != limbs; ++i)
+    {
+      t[i] = _in.v[i][_lane];
+    }
+    return detail::fe_from_radix(t, limbs, radix);
+  }
+
+  [[gnu::target("avx2")]] static void
+  mul(elem& _out, const elem& _a, const elem& _b) noexcept
+  {
+    __m256i a[10], b[10], c[20];
+    for (int i = 0; i != 10; ++i)
+    {
+      a[i] = _mm256_load_si256((const __m256i*)_a.v[i]);
+      b[i] = _mm256_load_si256((const __m256i*)_b.v[i]);
+    }
+    for (int i = 0; i != 20; ++i)
+    {
+      c[i] = _mm256_setzero_si256();
+    }
+
+    for (int i = 0; i != 10; ++i)
+    {
+      for (int j = 0; j != 10; ++j)
+      {
+        c[i + j] = _mm256_add_epi64(c[i + j], _mm256_mul_epu32(a[i], b[j]));
+      }
+    }
+
+    detail::x26_reduce_wide(_out, c);
+  }
+
+  [[gnu::target("avx2")]] static void
+  sqr(elem& _out, const elem& _a) noexcept
+  {
+    __m256i a[10], c[20];
+    for (int i = 0; i != 10; ++i)
+    {
+      a[i] = _mm256_load_si256((const __m256i*)_a.v[i]);
+    }
+    for (int i = 0; i != 20; ++i)
+    {
+      c[i] = _mm256_setzero_si256();
+    }
+
+    for (int i = 0; i != 10; ++i)
+    {
+      for (int j = i + 1; j != 10; ++j)
+      {
+        c[i + j] = _mm256_add_epi64(c[i + j], _mm256_mul_epu32(a[i], a[j]));
+      }
+    }
+    for (int i = 0; i != 19; ++i)
+    {
+      c[i] = _mm256_add_epi64(c[i], c[i]);
+    }
+    for (int i = 0; i != 10; ++i)
+    {
+      c[2 * i] = _mm256_add_epi64(c[2 * i], _mm256_mul_epu32(a[i], a[i]));
+    }
+
+    detail::x26_reduce_wide(_out, c);
+  }
+
+  [[gnu::target("avx2")]] static void
+  add(elem& _out, const elem& _a, const elem& _b) noexcept
+  {
+    __m256i d[11];
+    for (int i = 0; i != 10; ++i)
+    {
+      d[i] = _mm256_add_epi64(_mm256_load_si256((const __m256i*)_a.v[i]), _mm256_load_si256((const __m256i*)_b.v[i]));
+    }
+    d[10] = _mm256_setzero_si256();
+
+    detail::x26_carry(d);
+
+    for (int i = 0; i != 10; ++i)
+    {
+      _mm256_store_si256((__m256i*)_out.v[i], d[i]);
+    }
+  }
+
+  /* a + 32p - b, 32p because the top limb of p only has 22 bits */
+  [[gnu::target("avx2")]] static void
+  sub(elem& _out, const elem& _a, const elem& _b) noexcept
+  {
+    __m256i d[11];
+    for (int i = 0; i != 10; ++i)
+    {
+      const __m256i kp = _mm256_set1_epi64x(detail::fe_get_bits(fe_p, i * radix, radix) << 5);
+      d[i]             = _mm256_add_epi64(_mm256_load_si256((const __m256i*)_a.v[i]), kp);
+      d[i]             = _mm256_sub_epi64(d[i], _mm256_load_si256((const __m256i*)_b.v[i]));
+    }
+    d[10] = _mm256_setzero_si256();
+
+    detail::x26_carry(d);
+
+    for (int i = 0; i != 10; ++i)
+    {
+      _mm256_store_si256((__m256i*)_out.v[i], d[i]);
+    }
+  }
+
+  static bool
+  supported() noexcept
+  {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+  }
+};
+
+struct lanes_ifma
+{
+  using elem                          = fe_x8;
+  static constexpr std::size_t width  = 8;
+  static constexpr std::size_t limbs  = 5;
+  static constexpr std::size_t radix  = 52;
+  static constexpr const char* name   = "avx512 ifma 8x52";
+
+  static void
+  load(elem& _out, const fe* _in) noexcept
+  {
+    for (std::size_t l = 0; l != width; ++l)
+    {
+      put(_out, l, _in[l]);
+    }
+  }
+
+  static void
+  put(elem& _out, std::size_t _lane, const fe& _in) noexcept
+  {
+    for (std::size_t i = 0; i != limbs; ++i)
+    {
+      _out.v[i][_lane] = detail::fe_get_bits(_in, i * radix, i == 4 ? 48 : radix);
+    }
+  }
+
+  static fe
+  get(const elem& _in, std::size_t _lane) noexcept
+  {
+    std::uint64_t t[limbs];
+    for (std::size_t i = 0; i != limbs; ++i)
+    {
+      t[i] = _in.v[i][_lane];
+    }
+    return detail::fe_from_radix(t, limbs, radix);
+  }
+
+  [[gnu::target("avx512f,avx512ifma")]] static void
+  mul(elem& _out, const elem& _a, const elem& _b) noexcept
+  {
+    __m512i a[5], b[5], c[10];
+    for (int i = 0; i != 5; ++i)
+    {
+      a[i] = _mm512_load_si512((const __m512i*)_a.v[i]);
+      b[i] = _mm512_load_si512((const __m512i*)_b.v[i]);
+    }
+    for (int i = 0; i != 10; ++i)
+    {
+      c[i] = _mm512_setzero_si512();
+    }
+
+    for (int i = 0; i != 5; ++i)
+    {
+      for (int j = 0; j != 5; ++j)
+      {
+        c[i + j]     = _mm512_madd52lo_epu64(c[i + j], a[i], b[j]);
+        c[i + j + 1] = _mm512_madd52hi_epu64(c[i + j + 1], a[i], b[j]);
+      }
+    }
+
+    detail::x52_reduce_wide(_out, c);
+  }
+
+  [[gnu::target("avx512f,avx512ifma")]] static void
+  sqr(elem& _out, const elem& _a) noexcept
+  {
+    __m512i a[5], c[10];
+    for (int i = 0; i != 5; ++i)
+    {
+      a[i] = _mm512_load_si512((const __m512i*)_a.v[i]);
+    }
+    for (int i = 0; i != 10; ++i)
+    {
+      c[i] = _mm512_setzero_si512();
+    }
+
+    for (int i = 0; i != 5; ++i)
+    {
+      for (int j = i + 1; j != 5; ++j)
+      {
+        c[i + j]     = _mm512_madd52lo_epu64(c[i + j], a[i], a[j]);
+        c[i + j + 1] = _mm512_madd52hi_epu64(c[i + j + 1], a[i], a[j]);
+      }
+    }
+    for (int i = 0; i != 10; ++i)
+    {
+      c[i] = _mm512_add_epi64(c[i], c[i]);
+    }
+    for (int i = 0; i != 5; ++i)
+    {
+      c[2 * i]     = _mm512_madd52lo_epu64(c[2 * i], a[i], a[i]);
+      c[2 * i + 1] = _mm512_madd52hi_epu64(c[2 * i + 1], a[i], a[i]);
+    }
+
+    detail::x52_reduce_wide(_out, c);
+  }
+
+  [[gnu::target("avx512f,avx512ifma")]] static void
+  add(elem& _out, const elem& _a, const elem& _b) noexcept
+  {
+    __m512i d[6];
+    for (int i = 0; i != 5; ++i)
+    {
+      d[i] = _mm512_add_epi64(_mm512_load_si512((const __m512i*)_a.v[i]), _mm512_load_si512((const __m512i*)_b.v[i]));
+    }
+    d[5] = _mm512_setzero_si512();
+
+    detail::x52_carry(d);
+
+    for (int i = 0; i != 5; ++i)
+    {
+      _mm512_store_si512((__m512i*)_out.v[i], d[i]);
+    }
+  }
+
+  /* a + 32p - b, the top limb of p only has 48 bits */
+  [[gnu::target("avx512f,avx512ifma")]] static void
+  sub(elem& _out, const elem& _a, const elem& _b) noexcept
+  {
+    __m512i d[6];
+    for (int i = 0; i != 5; ++i)
+    {
+      const __m512i kp = _mm512_set1_epi64(detail::fe_get_bits(fe_p, i * radix, i == 4 ? 48 : radix) << 5);
+      d[i]             = _mm512_add_epi64(_mm512_load_si512((const __m512i*)_a.v[i]), kp);
+      d[i]             = _mm512_sub_epi64(d[i], _mm512_load_si512((const __m512i*)_b.v[i]));
+    }
+    d[5] = _mm512_setzero_si512();
+
+    detail::x52_carry(d);
+
+    for (int i = 0; i != 5; ++i)
+    {
+      _mm512_store_si512((__m512i*)_out.v[i], d[i]);
+    }
+  }
+
+  static bool
+  supported() noexcept
+  {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma");
+  }
+};
+
+/* fe_sqrt's addition chain on B::width elements at once, the roots still need the square check */
+template <class B>
+inline void
+fe_sqrt_pow(typename B::elem& _out, const typename B::elem& _a) noexcept
+{
+  using elem = typename B::elem;
+
+  // by reference, a 64 byte vector by value changes abi between gcc versions (-Wpsabi)
+  const auto sqr_n = [](const elem& _x, std::size_t _n)
+  {
+    elem r = _x;
+    while (_n--)
+    {
+      B::sqr(r, r);
+    }
+    return r;
+  };
+  const auto mul = [](const elem& _x, const elem& _y)
+  {
+    elem r;
+    B::mul(r, _x, _y);
+    return r;
+  };
+
+  const elem x2   = mul(sqr_n(_a, 1), _a);
+  const elem x3   = mul(sqr_n(x2, 1), _a);
+  const elem x6   = mul(sqr_n(x3, 3), x3);
+  const elem x9   = mul(sqr_n(x6, 3), x3);
+  const elem x11  = mul(sqr_n(x9, 2), x2);
+  const elem x22  = mul(sqr_n(x11, 11), x11);
+  const elem x44  = mul(sqr_n(x22, 22), x22);
+  const elem x88  = mul(sqr_n(x44, 44), x44);
+  const elem x176 = mul(sqr_n(x88, 88), x88);
+  const elem x220 = mul(sqr_n(x176, 44), x44);
+  const elem x223 = mul(sqr_n(x220, 3), x3);
+
+  elem t = mul(sqr_n(x223, 23), x22);
+  t      = mul(sqr_n(t, 6), x2);
+  _out   = sqr_n(t, 2);
+}
+
+/* fe_sqrt on every element through backend B, _ok gets 1 / 0 per element. _out may alias _in */
+template <class B>
+inline void
+fe_sqrt_many(std::span<const fe> _in, std::span<fe> _out, std::span<std::uint8_t> _ok) noexcept
+{
+  for (std::size_t base = 0; base < _in.size(); base += B::width)
+  {
+    const std::size_t n = std::min(B::width, _in.size() - base);
+
+    fe a[B::width]{};
+    std::copy_n(_in.begin() + base, n, a);
+
+    typename B::elem v, r;
+    B::load(v, a);
+    fe_sqrt_pow<B>(r, v);
+
+    for (std::size_t l = 0; l != n; ++l)
+    {
+      const fe root  = B::get(r, l);
+      _ok[base + l]  = fe_sqr(root) == a[l];
+      _out[base + l] = root;
+    }
+  }
+}
+
+} // namespace blue_crypto
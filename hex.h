@@ -0,0 +1,274 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+/*
+  hex <-> bytes for bulk key ingest, without going through mpz_set_str.
+
+  the vector decoders classify every character at once ('0'-'9', 'a'-'f', 'A'-'F', anything else
+  fails the whole run), turn them into nibbles with one blend and fuse the nibble pairs with
+  pmaddubsw. 32 chars -> 16 bytes per step on avx2, 16 -> 8 on ssse3, the tails and hosts with
+  neither go through a 256 entry table. encoding is a pshufb table lookup plus an interleave.
+*/
+
+namespace blue_crypto
+{
+
+namespace detail
+{
+
+struct hex_kernels
+{
+  bool avx2;
+  bool ssse3;
+  const char* name;
+};
+
+inline hex_kernels
+select_hex_kernels() noexcept
+{
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+  {
+    return {true, true, "avx2"};
+  }
+  if (__builtin_cpu_supports("ssse3"))
+  {
+    return {false, true, "ssse3"};
+  }
+#endif
+  return {false, false, "scalar"};
+}
+
+/* nibble value of every char, 0xff if it isn't a hex digit */
+struct hex_table
+{
+  std::uint8_t v[256];
+
+  constexpr hex_table() : v{}
+  {
+    for (int c = 0; c != 256; ++c)
+    {
+      v[c] = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : 0xff;
+    }
+  }
+};
+
+static constexpr hex_table hex_values{};
+static constexpr char hex_digits[] = "0123456789abcdef";
+
+inline bool
+hex_decode_scalar(const char* _in, std::byte* _out, std::size_t _n) noexcept
+{
+  std::uint8_t bad = 0;
+  for (std::size_t i = 0; i != _n; ++i)
+  {
+    const std::uint8_t hi = hex_values.v[static_cast<unsigned char>(_in[2 * i])];
+    const std::uint8_t lo = hex_values.v[static_cast<unsigned char>(_in[2 * i + 1])];
+    bad |= (hi | lo) & 0xf0;
+    _out[i] = std::byte(hi << 4 | lo);
+  }
+  return bad == 0;
+}
+
+inline void
+hex_encode_scalar(const std::byte* _in, char* _out, std::size_t _n) noexcept
+{
+  for (std::size_t i = 0; i != _n; ++i)
+  {
+    const unsigned b = std::to_integer<unsigned>(_in[i]);
+    _out[2 * i]      = hex_digits[b >> 4];
+    _out[2 * i + 1]  = hex_digits[b & 0xf];
+  }
+}
+
+#if defined(__x86_64__)
+
+/* 16 chars -> 8 bytes (in the low half), false if any of them isn't a hex digit */
+[[gnu::target("ssse3")]] inline bool
+hex_nibbles_ssse3(__m128i _c, __m128i& _out) noexcept
+{
+  const __m128i lc       = _mm_or_si128(_c, _mm_set1_epi8(0x20));
+  const __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(_c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(_c, _mm_set1_epi8('9' + 1)));
+  const __m128i is_alpha = _mm_and_si128(_mm_cmpgt_epi8(lc, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lc, _mm_set1_epi8('f' + 1)));
+
+  // digits are c - '0', letters lc - 'a' + 10, picked by the class masks
+  const __m128i v = _mm_or_si128(_mm_and_si128(is_digit, _mm_sub_epi8(_c, _mm_set1_epi8('0'))),
+                                 _mm_and_si128(is_alpha, _mm_sub_epi8(lc, _mm_set1_epi8('a' - 10))));
+
+  // hi * 16 + lo per char pair, then the 16 bit results down to bytes
+  const __m128i pairs = _mm_maddubs_epi16(v, _mm_set1_epi16(0x0110));
+  _out                = _mm_packus_epi16(pairs, pairs);
+
+  return _mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) == 0xffff;
+}
+
+[[gnu::target("ssse3")]] inline bool
+hex_decode_ssse3(const char* _in, std::byte* _out, std::size_t _n) noexcept
+{
+  bool ok       = true;
+  std::size_t i = 0;
+  for (; i + 8 <= _n; i += 8)
+  {
+    __m128i b;
+    ok &= hex_nibbles_ssse3(_mm_loadu_si128((const __m128i*)(_in + 2 * i)), b);
+    _mm_storel_epi64((__m128i*)(_out + i), b);
+  }
+  return hex_decode_scalar(_in + 2 * i, _out + i, _n - i) && ok;
+}
+
+[[gnu::target("avx2")]] inline bool
+hex_decode_avx2(const char* _in, std::byte* _out, std::size_t _n) noexcept
+{
+  std::uint32_t bad = 0;
+  std::size_t i     = 0;
+  for (; i + 16 <= _n; i += 16)
+  {
+    const __m256i c        = _mm256_loadu_si256((const __m256i*)(_in + 2 * i));
+    const __m256i lc       = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+    const __m256i is_digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+    const __m256i is_alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lc, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lc));
+
+    const __m256i v = _mm256_or_si256(_mm256_and_si256(is_digit, _mm256_sub_epi8(c, _mm256_set1_epi8('0'))),
+                                      _mm256_and_si256(is_alpha, _mm256_sub_epi8(lc, _mm256_set1_epi8('a' - 10))));
+
+    const __m256i pairs  = _mm256_maddubs_epi16(v, _mm256_set1_epi16(0x0110));
+    const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(pairs, pairs), 0x08);
+    _mm_storeu_si128((__m128i*)(_out + i), _mm256_castsi256_si128(packed));
+
+    bad |= ~static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_alpha)));
+  }
+  return hex_decode_ssse3(_in + 2 * i, _out + i, _n - i) && bad == 0;
+}
+
+[[gnu::target("ssse3")]] inline void
+hex_encode_ssse3(const std::byte* _in, char* _out, std::size_t _n) noexcept
+{
+  const __m128i digits = _mm_loadu_si128((const __m128i*)hex_digits);
+  const __m128i mask   = _mm_set1_epi8(0x0f);
+
+  std::size_t i = 0;
+  for (; i + 16 <= _n; i += 16)
+  {
+    const __m128i b  = _mm_loadu_si128((const __m128i*)(_in + i));
+    const __m128i hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(b, 4), mask));
+    const __m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(b, mask));
+
+    _mm_storeu_si128((__m128i*)(_out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128((__m128i*)(_out + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+  }
+  hex_encode_scalar(_in + i, _out + 2 * i, _n - i);
+}
+
+[[gnu::target("avx2")]] inline void
+hex_encode_avx2(const std::byte* _in, char* _out, std::size_t _n) noexcept
+{
+  const __m256i digits = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)hex_digits));
+  const __m256i mask   = _mm256_set1_epi8(0x0f);
+
+  std::size_t i = 0;
+  for (; i + 32 <= _n; i += 32)
+  {
+    const __m256i b  = _mm256_loadu_si256((const __m256i*)(_in + i));
+    const __m256i hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(b, 4), mask));
+    const __m256i lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(b, mask));
+
+    // unpacks stay inside 128 bit lanes: a = bytes 0-7 | 16-23, b = 8-15 | 24-31
+    const __m256i a = _mm256_unpacklo_epi8(hi, lo);
+    const __m256i c = _mm256_unpackhi_epi8(hi, lo);
+    _mm256_storeu_si256((__m256i*)(_out + 2 * i), _mm256_permute2x128_si256(a, c, 0x20));
+    _mm256_storeu_si256((__m256i*)(_out + 2 * i + 32), _mm256_permute2x128_si256(a, c, 0x31));
+  }
+  hex_encode_ssse3(_in + i, _out + 2 * i, _n - i);
+}
+
+#endif
+
+} // namespace detail
+
+/* resolved once during static init, like fe_kernel */
+inline const detail::hex_kernels hex_kernel = detail::select_hex_kernels();
+
+/* _in is 2 * _out.size() hex digits (either case, no 0x). false if any of them isn't one, _out is garbage then */
+inline bool
+hex_decode(std::span<const char> _in, std::span<std::byte> _out) noexcept
+{
+  assert(_in.size() == 2 * _out.size());
+
+#if defined(__x86_64__)
+  if (hex_kernel.avx2) [[likely]]
+  {
+    return detail::hex_decode_avx2(_in.data(), _out.data(), _out.size());
+  }
+  if (hex_kernel.ssse3)
+  {
+    return detail::hex_decode_ssse3(_in.data(), _out.data(), _out.size());
+  }
+#endif
+  return detail::hex_decode_scalar(_in.data(), _out.data(), _out.size());
+}
+
+/* lowercase, _out is 2 * _in.size() chars with no terminator */
+inline void
+hex_encode(std::span<const std::byte> _in, std::span<char> _out) noexcept
+{
+  assert(_out.size() == 2 * _in.size());
+
+#if defined(__x86_64__)
+  if (hex_kernel.avx2) [[likely]]
+  {
+    return detail::hex_encode_avx2(_in.data(), _out.data(), _in.size());
+  }
+  if (hex_kernel.ssse3)
+  {
+    return detail::hex_encode_ssse3(_in.data(), _out.data(), _in.size());
+  }
+#endif
+  detail::hex_encode_scalar(_in.data(), _out.data(), _in.size());
+}
+
+/*
+  a buffer of fixed width big endian hex keys (_key_bytes = 32 or 64, so 64 or 128 digits)
+  starting every _stride chars (>= 2 * _key_bytes, e.g. + 1 for newline separated files)
+  straight into little endian limbs, _key_bytes / 8 per key: the fe / sc layout for 32 byte
+  keys. _valid gets 1 / 0 per key (a bad key's limbs are garbage), returns true if all parsed
+*/
+inline bool
+hex_decode_keys(std::span<const char> _in, std::size_t _key_bytes, std::size_t _stride, std::span<std::uint64_t> _limbs,
+                std::span<std::uint8_t> _valid) noexcept
+{
+  assert(_key_bytes == 32 || _key_bytes == 64);
+  assert(_stride >= 2 * _key_bytes);
+
+  const std::size_t words = _key_bytes / 8;
+  const std::size_t n     = _valid.size();
+  assert(_limbs.size() == n * words);
+  assert(n == 0 || _in.size() >= (n - 1) * _stride + 2 * _key_bytes);
+
+  std::byte be[64];
+  bool all = true;
+  for (std::size_t k = 0; k != n; ++k)
+  {
+    _valid[k] = hex_decode(_in.subspan(k * _stride, 2 * _key_bytes), {be, _key_bytes});
+    all &= _valid[k] != 0;
+
+    for (std::size_t j = 0; j != words; ++j)
+    {
+      std::uint64_t w;
+      std::memcpy(&w, be + _key_bytes - 8 * (j + 1), 8);
+      _limbs[k * words + j] = __builtin_bswap64(w);
+    }
+  }
+  return all;
+}
+
+} // namespace blue_crypto
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <thread>
+
+#include <sched.h>
+
+#include "keygen.h"
+
+/*
+  pool of precomputed ephemeral key pairs so a handshake doesn't pay for k*G inline.
+
+  the pool is a bounded lock free MPMC ring (vyukov style, a sequence number per slot), so
+  take() is a couple of atomics and a copy. a background thread tops it up with bulk_keygen
+  batches (shared inversions) whenever it drops below the low water mark, running under
+  SCHED_IDLE so it only gets cpu time nobody else wants. every key is handed out once, the
+  slot is wiped as soon as it has been copied out.
+*/
+
+namespace blue_crypto::secp256k1
+{
+
+struct key_pair
+{
+  std::array<std::byte, privkey_size> priv{};
+  std::array<std::byte, pubkey_size> pub{};
+
+  key_pair() = default;
+  key_pair(const key_pair&)            = default;
+  key_pair& operator=(const key_pair&) = default;
+
+  ~key_pair() { secure_wipe(priv.data(), priv.size()); }
+};
+
+class key_pool
+{
+public:
+  /* _capacity is rounded up to a power of two, the pool starts full */
+  explicit key_pool(std::size_t _capacity = 4096, std::size_t _low_water = 0)
+      : mask_(std::bit_ceil(std::max<std::size_t>(_capacity, keygen_chunk)) - 1),
+        low_water_(_low_water ? _low_water : (mask_ + 1) / 2),
+        slots_(std::make_unique<slot[]>(mask_ + 1))
+  {
+    for (std::size_t i = 0; i <= mask_; ++i)
+    {
+      slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    refill();
+    worker_ = std::thread([this] { run(); });
+  }
+
+  key_pool(const key_pool&)            = delete;
+  key_pool& operator=(const key_pool&) = delete;
+
+  ~key_pool()
+  {
+    stop_.store(true);
+    kick();
+    worker_.join();
+
+    for (std::size_t i = 0; i <= mask_; ++i)
+    {
+      secure_wipe(&slots_[i].kp, sizeof(key_pair));
+    }
+  }
+
+  /* nullopt if the pool ran dry */
+  std::optional<key_pair>
+  try_take()
+  {
+    std::size_t pos = head_.load(std::memory_order_relaxed);
+    slot* s;
+
+    for (;;)
+    {
+      s                         = &slots_[pos & mask_];
+      const std::size_t seq     = s->seq.load(std::memory_order_acquire);
+      const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+
+      if (diff == 0)
+      {
+        if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        kick();
+        return std::nullopt;
+      }
+      else
+      {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+
+    std::optional<key_pair> out{s->kp};
+    secure_wipe(&s->kp, sizeof(key_pair));
+    s->seq.store(pos + mask_ + 1, std::memory_order_release);
+
+    if (size() < low_water_)
+    {
+      kick();
+    }
+    return out;
+  }
+
+  /* never blocks on the refill thread, an empty pool just costs one inline keygen */
+  key_pair
+  take()
+  {
+    if (auto kp = try_take()) [[likely]]
+    {
+      return *kp;
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+
+    key_pair out;
+    bulk_keygen(out.priv, out.pub, 1);
+    return out;
+  }
+
+  /* approximate, other threads may be taking / refilling */
+  std::size_t
+  size() const
+  {
+    // a take can move head past a tail that the refill thread hasn't published yet, that
+    // reads as empty rather than as a wrapped difference
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+  std::size_t
+  capacity() const
+  {
+    return mask_ + 1;
+  }
+
+  std::size_t
+  misses() const
+  {
+    return misses_.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct slot
+  {
+    std::atomic<std::size_t> seq;
+    key_pair kp;
+  };
+
+  bool
+  push(const std::byte* _priv, const std::byte* _pub)
+  {
+    // only the refill side pushes, so no cas on tail_
+    const std::size_t pos = tail_.load(std::memory_order_relaxed);
+    slot& s               = slots_[pos & mask_];
+
+    if (s.seq.load(std::memory_order_acquire) != pos)
+    {
+      return false;
+    }
+
+    std::copy_n(_priv, privkey_size, s.kp.priv.begin());
+    std::copy_n(_pub, pubkey_size, s.kp.pub.begin());
+    s.seq.store(pos + 1, std::memory_order_release);
+    tail_.store(pos + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /* top up to capacity in keygen_chunk batches */
+  void
+  refill()
+  {
+    std::array<std::byte, keygen_chunk * privkey_size> priv;
+    std::array<std::byte, keygen_chunk * pubkey_size> pub;
+
+    while (!stop_.load(std::memory_order_relaxed))
+    {
+      const std::size_t n = std::min(keygen_chunk, capacity() - size());
+      if (n == 0)
+      {
+        break;
+      }
+
+      bulk_keygen(std::span{priv}.first(n * privkey_size), std::span{pub}.first(n * pubkey_size), 1);
+
+      std::size_t i = 0;
+      while (i != n && push(&priv[i * privkey_size], &pub[i * pubkey_size]))
+      {
+        ++i;
+      }
+      if (i != n)
+      {
+        break;
+      }
+    }
+
+    secure_wipe(priv.data(), priv.size());
+  }
+
+  void
+  kick()
+  {
+    wake_.fetch_add(1, std::memory_order_release);
+    wake_.notify_one();
+  }
+
+  void
+  run()
+  {
+    // linux: pid 0 is the calling thread, SCHED_IDLE only runs when the core is otherwise idle
+    sched_param param{};
+    sched_setscheduler(0, SCHED_IDLE, &param);
+
+    while (!stop_.load())
+    {
+      const std::uint32_t seen = wake_.load(std::memory_order_acquire);
+      if (size() < low_water_)
+      {
+        refill();
+        continue;
+      }
+      wake_.wait(seen);
+    }
+  }
+
+  const std::size_t mask_;
+  const std::size_t low_water_;
+  std::unique_ptr<slot[]> slots_;
+
+  alignas(64) std::atomic<std::size_t> head_{0};
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  alignas(64) std::atomic<std::uint32_t> wake_{0};
+  std::atomic<bool> stop_{false};
+  std::atomic<std::size_t> misses_{0};
+
+  std::thread worker_;
+};
+
+} // namespace blue_crypto::secp256k1
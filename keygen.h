@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "curve_batch.h"
+#include "drbg.h"
+#include "rng.h"
+
+/*
+  bulk key pair generation: random scalars from the per thread chacha_drbg, k*G through the fixed base table
+  in lockstep affine (so the results come out normalized, one shared inversion per add step,
+  constant time in the private keys), written out as 32 byte private keys and 33 byte
+  compressed public keys.
+*/
+
+namespace blue_crypto::secp256k1
+{
+
+static constexpr std::size_t privkey_size = 32;
+static constexpr std::size_t pubkey_size  = 33;
+
+/* keys per lockstep batch, big enough that the shared inversions are noise */
+static constexpr std::size_t keygen_chunk = 256;
+
+/*
+  uniform in [1, n), rejection sampled (a 256 bit draw is >= n with probability ~2^-128).
+  _rng is anything with fill(std::span<std::byte>), os_random or chacha_drbg
+*/
+template <class Rng>
+inline std::array<std::uint64_t, 4>
+random_scalar(Rng& _rng)
+{
+  for (;;)
+  {
+    std::array<std::uint64_t, 4> k;
+    _rng.fill(std::as_writable_bytes(std::span{k}));
+
+    if ((k[0] | k[1] | k[2] | k[3]) == 0)
+    {
+      continue;
+    }
+
+    for (std::size_t i = 4; i-- != 0;)
+    {
+      if (k[i] != group_order[i])
+      {
+        if (k[i] < group_order[i])
+        {
+          return k;
+        }
+        break;
+      }
+    }
+  }
+}
+
+/* _priv and _pub hold _priv.size() / 32 keys back to back, one stride of the keys per thread */
+inline void
+bulk_keygen(std::span<std::byte> _priv, std::span<std::byte> _pub, unsigned _threads = 0)
+{
+  assert(_priv.size() % privkey_size == 0);
+
+  const std::size_t count = _priv.size() / privkey_size;
+  assert(_pub.size() == count * pubkey_size);
+
+  if (count == 0)
+  {
+    return;
+  }
+
+  if (_threads == 0)
+  {
+    _threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  const std::size_t per = (count + _threads - 1) / _threads;
+
+  const auto work = [&](std::size_t _from)
+  {
+    chacha_drbg& rng = chacha_drbg::local();
+    std::vector<std::array<std::uint64_t, 4>> k(keygen_chunk);
+    std::vector<crv_p> P(keygen_chunk);
+
+    const std::size_t end = std::min(count, _from + per);
+    for (std::size_t base = _from; base < end; base += keygen_chunk)
+    {
+      const std::size_t n = std::min(keygen_chunk, end - base);
+
+      for (std::size_t i = 0; i != n; ++i)
+      {
+        k[i] = random_scalar(rng);
+      }
+
+      fixed_base_mul_many(std::span{k}.first(n), std::span{P}.first(n));
+
+      for (std::size_t i = 0; i != n; ++i)
+      {
+        blue_crypto::detail::store_be256(k[i].data(), &_priv[(base + i) * privkey_size]);
+        to_compressed(P[i], &_pub[(base + i) * pubkey_size]);
+      }
+    }
+
+    secure_wipe(k.data(), k.size() * sizeof(k[0]));
+  };
+
+  std::vector<std::thread> pool;
+  for (std::size_t from = per; from < count; from += per)
+  {
+    pool.emplace_back(work, from);
+  }
+  work(0);
+
+  for (auto& t : pool)
+  {
+    t.join();
+  }
+}
+
+} // namespace blue_crypto::secp256k1
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "curve.h"
+#include "sec1.h"
+
+/*
+  a point that stays jacobian until somebody needs its bytes. adding, doubling and comparing
+  work on the projective form directly (point_eq needs no inversion), normalizing is done at
+  most once (Z = 1 afterwards, so the coordinates are the affine ones) and a span of pending
+  points is normalized together with one fe_batch_inv.
+*/
+
+namespace blue_crypto::secp256k1
+{
+
+class lazy_point
+{
+public:
+  lazy_point() = default;
+  explicit lazy_point(const jcbn_crv_p& _p) : p_(_p) {}
+  explicit lazy_point(const crv_p& _p) : p_(_p == a_identity_element ? j_identity_element : to_jacobian(_p)) {}
+
+  const jcbn_crv_p&
+  jacobian() const noexcept
+  {
+    return p_;
+  }
+
+  bool
+  is_identity() const noexcept
+  {
+    return secp256k1::is_identity(p_);
+  }
+
+  /* affine already, O counts as normalized since it has nothing to divide out */
+  bool
+  is_normalized() const noexcept
+  {
+    return p_.z == fe_one || is_identity();
+  }
+
+  /* one fe_inv if still pending */
+  void
+  normalize() noexcept
+  {
+    if (!is_normalized())
+    {
+      const crv_p a = from_jacobian(p_);
+      p_            = {a.x, a.y, fe_one};
+    }
+  }
+
+  /* normalizes on first use, O maps to a_identity_element */
+  crv_p
+  affine() noexcept
+  {
+    normalize();
+    return is_identity() ? a_identity_element : crv_p{p_.x, p_.y};
+  }
+
+  lazy_point&
+  operator+=(const lazy_point& _other) noexcept
+  {
+    p_ = point_add(p_, _other.p_);
+    return *this;
+  }
+
+  friend lazy_point
+  operator+(lazy_point _a, const lazy_point& _b) noexcept
+  {
+    return _a += _b;
+  }
+
+  lazy_point
+  doubled() const noexcept
+  {
+    return lazy_point{point_double(p_)};
+  }
+
+  bool
+  operator==(const lazy_point& _other) const noexcept
+  {
+    return point_eq(p_, _other.p_);
+  }
+
+  bool
+  operator!=(const lazy_point& _other) const noexcept
+  {
+    return !point_eq(p_, _other.p_);
+  }
+
+  /* sec1_encode of the affine point (33 or 65 bytes by _out.size()), false for O */
+  bool
+  serialize(std::span<std::byte> _out) noexcept
+  {
+    return sec1_encode(affine(), _out);
+  }
+
+private:
+  jcbn_crv_p p_ = j_identity_element;
+};
+
+/* normalize every pending point of _pts with a single fe_batch_inv, already affine ones are skipped */
+inline void
+normalize_all(std::span<lazy_point> _pts)
+{
+  std::vector<std::size_t> pending;
+  std::vector<jcbn_crv_p> in;
+  for (std::size_t i = 0; i != _pts.size(); ++i)
+  {
+    if (!_pts[i].is_normalized())
+    {
+      pending.push_back(i);
+      in.push_back(_pts[i].jacobian());
+    }
+  }
+
+  std::vector<crv_p> out(in.size());
+  batch_from_jacobian(in, out);
+
+  for (std::size_t k = 0; k != pending.size(); ++k)
+  {
+    _pts[pending[k]] = lazy_point{out[k]};
+  }
+}
+
+/*
+  _pts back to back into _out as 33 or 65 byte encodings (stride _out.size() / _pts.size()),
+  normalizing whatever is pending in one go. O can't be encoded, _ok gets 0 for those (and
+  their bytes are left alone). returns true if every point was written
+*/
+inline bool
+serialize_all(std::span<lazy_point> _pts, std::span<std::byte> _out, std::span<std::uint8_t> _ok)
+{
+  assert(_ok.size() == _pts.size());
+  if (_pts.empty())
+  {
+    return true;
+  }
+
+  const std::size_t stride = _out.size() / _pts.size();
+  assert(_out.size() == _pts.size() * stride);
+
+  normalize_all(_pts);
+
+  bool all = true;
+  for (std::size_t i = 0; i != _pts.size(); ++i)
+  {
+    _ok[i] = _pts[i].serialize(_out.subspan(i * stride, stride));
+    all &= _ok[i] != 0;
+  }
+  return all;
+}
+
+} // namespace blue_crypto::secp256k1
@@ -6,7 +6,30 @@
 #include <chrono>
 #include <vector>
 #include <bitset>
+#include <algorithm>
+#include <sstream>
 #include "crypto.h"
+#include "curve.h"
+#include "scalar.h"
+#include "curve_simd.h"
+#include "packed_latency_bench.h"
+#include "curve_batch.h"
+#include "curve_walk.h"
+#include "keygen.h"
+#include "key_pool.h"
+#include "ecdsa.h"
+#include "schnorr.h"
+#include "sec1.h"
+#include "hex.h"
+#include "validate.h"
+#include "ecdh.h"
+#include "lazy_point.h"
+#include "sha256_mb.h"
+#include "ecies.h"
+#include "drbg.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace blue_crypto;
 using ix = GmpWrapper;
@@ -351,6 +374,1725 @@ main()
   from_jacobian(shared_secretAJ, mod_global).print();
   from_jacobian(shared_secretBJ, mod_global).print();
 
+  std::cout << "field kernel: " << fe_kernel.name << "\n";
+
+  // both kernels have to agree, whichever one got picked
+  {
+    fe a = fe_from_ix(privKeyA), b = fe_from_ix(privKeyB);
+    for (int i = 0; i != 1000; ++i)
+    {
+      fe pm, ps;
+      detail::fe_mul_portable(pm, a, b);
+      detail::fe_sqr_portable(ps, a);
+      assert(fe_mul(a, b) == pm);
+      assert(fe_sqr(a) == ps);
+      assert(fe_to_ix(pm) == fe_to_ix(a) * fe_to_ix(b) % mod_global);
+      a = pm;
+      b = fe_add(ps, b);
+    }
+    assert(fe_mul(fe_inv(a), a) == fe_one);
+  }
+
+  const secp256k1::jcbn_crv_p pubKeyA_fe = secp256k1::windowed_scalar_mul(secp256k1::precompute(secp256k1::to_jacobian(secp256k1::G)), privKeyA);
+  const secp256k1::jcbn_crv_p pubKeyB_fe = secp256k1::windowed_scalar_mul(secp256k1::precompute(secp256k1::to_jacobian(secp256k1::G)), privKeyB);
+
+  secp256k1::jcbn_crv_p shared_secretA_fe, shared_secretB_fe;
+
+  std::cout << "fixed width jacobian windowed: \n";
+  {
+    perf_ _("fixed width jacobian windowed");
+
+    shared_secretA_fe = secp256k1::windowed_scalar_mul(secp256k1::precompute(pubKeyB_fe), privKeyA);
+    shared_secretB_fe = secp256k1::windowed_scalar_mul(secp256k1::precompute(pubKeyA_fe), privKeyB);
+  }
+
+  const crv_p shared_secret_ref = from_jacobian(shared_secretAJ, mod_global);
+  assert(fe_to_ix(secp256k1::from_jacobian(shared_secretA_fe).x) == shared_secret_ref.x);
+  assert(fe_to_ix(secp256k1::from_jacobian(shared_secretA_fe).y) == shared_secret_ref.y);
+  assert(secp256k1::from_jacobian(shared_secretA_fe) == secp256k1::from_jacobian(shared_secretB_fe));
+  secp256k1::from_jacobian(shared_secretA_fe).print();
+
+  // lockstep batch ECDH, every lane has its own peer and scalar
+  {
+    static constexpr std::size_t batch = 64;
+
+    const auto G_fe_precomp = secp256k1::precompute(secp256k1::to_jacobian(secp256k1::G));
+
+    std::vector<ix> scalars;
+    std::vector<std::vector<secp256k1::jcbn_crv_p>> peers;
+    for (std::size_t i = 0; i != batch; ++i)
+    {
+      scalars.push_back((privKeyA * (int)(i + 1) + privKeyB) % mod_global);
+      peers.push_back(secp256k1::precompute(secp256k1::windowed_scalar_mul(G_fe_precomp, privKeyB * (int)(i + 7) % mod_global)));
+    }
+
+    std::vector<const std::vector<secp256k1::jcbn_crv_p>*> peer_ptrs;
+    for (const auto& peer : peers)
+    {
+      peer_ptrs.push_back(&peer);
+    }
+
+    std::vector<secp256k1::jcbn_crv_p> expected(batch), got(batch);
+
+    std::cout << "lane backend: " << secp256k1::lane_backend_name(secp256k1::lane_kernel) << "\n";
+    {
+      perf_ _("64x sequential ECDH");
+      for (std::size_t i = 0; i != batch; ++i)
+      {
+        expected[i] = secp256k1::windowed_scalar_mul(peers[i], scalars[i]);
+      }
+    }
+    {
+      perf_ _("64x lane parallel ECDH");
+      secp256k1::batch_windowed_scalar_mul(peer_ptrs, scalars, got);
+    }
+
+    const auto check = [&]()
+    {
+      for (std::size_t i = 0; i != batch; ++i)
+      {
+        assert(secp256k1::from_jacobian(got[i]) == secp256k1::from_jacobian(expected[i]));
+      }
+    };
+    check();
+
+    if (lanes_avx2::supported())
+    {
+      got.assign(batch, secp256k1::j_identity_element);
+      secp256k1::batch_windowed_scalar_mul<lanes_avx2>(peer_ptrs, scalars, got);
+      check();
+    }
+    if (lanes_ifma::supported())
+    {
+      got.assign(batch, secp256k1::j_identity_element);
+      secp256k1::batch_windowed_scalar_mul<lanes_ifma>(peer_ptrs, scalars, got);
+      check();
+    }
+  }
+
+  // lockstep affine vs jacobian + from_jacobian, different base point per entry
+  {
+    const auto G_fe_precomp = secp256k1::precompute(secp256k1::to_jacobian(secp256k1::G));
+
+    for (const std::size_t batch : {4, 16, 64, 256})
+    {
+      std::vector<ix> scalars;
+      std::vector<std::vector<secp256k1::jcbn_crv_p>> bases;
+      for (std::size_t i = 0; i != batch; ++i)
+      {
+        scalars.push_back((privKeyB * (int)(i + 3) + privKeyA) % mod_global);
+        bases.push_back(secp256k1::precompute(secp256k1::windowed_scalar_mul(G_fe_precomp, privKeyA * (int)(i + 11) % mod_global)));
+      }
+
+      std::vector<const std::vector<secp256k1::jcbn_crv_p>*> base_ptrs;
+      for (const auto& base : bases)
+      {
+        base_ptrs.push_back(&base);
+      }
+
+      std::vector<secp256k1::crv_p> expected(batch), got(batch);
+
+      const auto t0 = std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i != batch; ++i)
+      {
+        expected[i] = secp256k1::from_jacobian(secp256k1::windowed_scalar_mul(bases[i], scalars[i]));
+      }
+      const auto t1 = std::chrono::steady_clock::now();
+
+      const auto tables = secp256k1::to_affine_tables(base_ptrs);
+      std::vector<const std::vector<secp256k1::crv_p>*> table_ptrs;
+      for (const auto& table : tables)
+      {
+        table_ptrs.push_back(&table);
+      }
+      secp256k1::batch_windowed_scalar_mul_affine(table_ptrs, scalars, got);
+      const auto t2 = std::chrono::steady_clock::now();
+
+      assert(got == expected);
+
+      std::cout << batch << "x k*P jacobian: " << std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / batch
+                << " us/op, lockstep affine: " << std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() / batch
+                << " us/op\n";
+    }
+  }
+
+  // static server key against many peers: plan once, stream the peers through it
+  {
+    static constexpr std::size_t batch = 512;
+
+    const auto G_fe_precomp = secp256k1::precompute(secp256k1::to_jacobian(secp256k1::G));
+
+    std::vector<secp256k1::crv_p> peers;
+    for (std::size_t i = 0; i != batch; ++i)
+    {
+      peers.push_back(secp256k1::from_jacobian(secp256k1::windowed_scalar_mul(G_fe_precomp, privKeyB * (int)(i + 5) % mod_global)));
+    }
+
+    std::vector<secp256k1::crv_p> expected(batch), got(batch);
+    {
+      perf_ _("512x ECDH, precompute per peer");
+      for (std::size_t i = 0; i != batch; ++i)
+      {
+        const auto table = secp256k1::precompute(secp256k1::to_jacobian(peers[i]));
+        expected[i]      = secp256k1::from_jacobian(secp256k1::windowed_scalar_mul(table, privKeyA));
+      }
+    }
+    {
+      perf_ _("512x ECDH, fixed scalar plan");
+      secp256k1::fixed_scalar_mul_many(secp256k1::make_scalar_plan(privKeyA), peers, got);
+    }
+    assert(got == expected);
+
+    // the sc plan (all 64 windows) gives the same, zero windows and k = 0 included
+    secp256k1::fixed_scalar_mul_many(secp256k1::make_scalar_plan(sc_from_ix(privKeyA)), peers, got);
+    assert(got == expected);
+    for (const ix& k : {ix{0}, ix{1}, ix{"0x10000000000000000f"}})
+    {
+      std::vector<secp256k1::crv_p> few(3);
+      secp256k1::fixed_scalar_mul_many(secp256k1::make_scalar_plan(sc_from_ix(k)), std::span{peers}.first(3), few);
+      for (std::size_t i = 0; i != few.size(); ++i)
+      {
+        assert(few[i] == secp256k1::from_jacobian(secp256k1::windowed_scalar_mul(secp256k1::precompute(secp256k1::to_jacobian(peers[i])), k)));
+      }
+    }
+  }
+
+  // consecutive / strided keys: walk vs a scalar mul per key
+  {
+    static constexpr std::size_t count = 1 << 18;
+
+    const auto G_fe_precomp = secp256k1::precompute(secp256k1::to_jacobian(secp256k1::G));
+    const ix stride         = 3;
+
+    std::vector<secp256k1::crv_p> keys(count);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    secp256k1::walk_keys(privKeyA, stride, keys);
+    const auto t1 = std::chrono::steady_clock::now();
+
+    const double secs = std::chrono::duration<double>(t1 - t0).count();
+    std::cout << "key walk: " << static_cast<std::uint64_t>(count / secs) << " keys/sec (" << std::thread::hardware_concurrency()
+              << " threads)\n";
+
+    for (const std::size_t i : {std::size_t{0}, std::size_t{1}, std::size_t{1023}, std::size_t{1024}, count / 2, count - 1})
+    {
+      const ix k = privKeyA + stride * (int)i;
+      assert(keys[i] == secp256k1::from_jacobian(secp256k1::windowed_scalar_mul(G_fe_precomp, k)));
+    }
+
+    std::vector<secp256k1::crv_p> split(5000);
+    secp256k1::walk_keys(privKeyA, stride, split, 4);
+    assert(std::equal(split.begin(), split.end(), keys.begin()));
+
+    // walking across k = n gives O, the key before it needs the slow path (C == -4G)
+    const ix order = "0xFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141";
+    std::vector<secp256k1::crv_p> around(8);
+    secp256k1::walk_keys(order - 4, 1, around, 1);
+    assert(around[4] == secp256k1::a_identity_element);
+    assert(around[5] == secp256k1::G);
+    assert(around[3].x == secp256k1::G.x && around[3].y == fe_neg(secp256k1::G.y));
+  }
+
+  // constant time fixed base mul vs windowed_scalar_mul: zero / all-zero windows, n - 1 and random keys
+  {
+    const auto G_fe_precomp = secp256k1::precompute(secp256k1::to_jacobian(secp256k1::G));
+
+    std::vector<std::array<std::uint64_t, 4>> ks = {{0, 0, 0, 0},
+                                                    {1, 0, 0, 0},
+                                                    {0, 0, 0, 1ull << 60},
+                                                    {0x10, 0, 0x100, 0},
+                                                    {~0ull, ~0ull, ~0ull, 0x0fffffffffffffffull},
+                                                    {0xBFD25E8CD0364140ull, 0xBAAEDCE6AF48A03Bull, 0xFFFFFFFFFFFFFFFEull, 0xFFFFFFFFFFFFFFFFull}};
+    for (int i = 0; i != 64; ++i)
+    {
+      ks.push_back(secp256k1::random_scalar(chacha_drbg::local()));
+    }
+
+    for (const auto& k : ks)
+    {
+      sc s;
+      std::copy(k.begin(), k.end(), s.n);
+      const auto ref = secp256k1::from_jacobian(secp256k1::windowed_scalar_mul(G_fe_precomp, sc_to_ix(s)));
+      assert(secp256k1::from_jacobian(secp256k1::fixed_base_mul(k)) == ref);
+    }
+    assert(secp256k1::is_identity(secp256k1::fixed_base_mul(std::array<std::uint64_t, 4>{})));
+
+    // lockstep batch (k = 0 in it forces the one at a time redo) and the plain lockstep
+    std::vector<secp256k1::crv_p> many(ks.size());
+    for (const std::size_t skip : {std::size_t{0}, std::size_t{1}})
+    {
+      const std::span<const std::array<std::uint64_t, 4>> in = std::span{ks}.subspan(skip);
+      secp256k1::fixed_base_mul_many(in, std::span{many}.first(in.size()));
+      for (std::size_t i = 0; i != in.size(); ++i)
+      {
+        assert(many[i] == secp256k1::from_jacobian(secp256k1::fixed_base_mul(in[i])));
+      }
+    }
+
+    // the complete add on its exceptional inputs for the incomplete formulas: O + G, G + G, -G + G
+    const secp256k1::proj_crv_p O{fe_zero, fe_one, fe_zero}, PG{secp256k1::G.x, secp256k1::G.y, fe_one},
+        NG{secp256k1::G.x, fe_neg(secp256k1::G.y), fe_one};
+    const auto affine = [](const secp256k1::proj_crv_p& _p)
+    {
+      const fe zi = fe_inv(_p.z);
+      return secp256k1::crv_p{fe_mul(_p.x, zi), fe_mul(_p.y, zi)};
+    };
+    assert(affine(secp256k1::point_add_complete(O, secp256k1::G)) == secp256k1::G);
+    assert(affine(secp256k1::point_add_complete(PG, secp256k1::G)) ==
+           secp256k1::from_jacobian(secp256k1::point_double(secp256k1::to_jacobian(secp256k1::G))));
+    assert(fe_is_zero(secp256k1::point_add_complete(NG, secp256k1::G).z));
+  }
+
+  // bulk key pairs: fixed base table + lockstep affine vs windowed_scalar_mul + from_jacobian per key
+  {
+    static constexpr std::size_t count = 1 << 16;
+
+    const auto G_fe_precomp = secp256k1::precompute(secp256k1::to_jacobian(secp256k1::G));
+
+    std::vector<std::byte> priv(count * secp256k1::privkey_size), pub(count * secp256k1::pubkey_size);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    secp256k1::bulk_keygen(priv, pub);
+    const auto t1 = std::chrono::steady_clock::now();
+
+    for (std::size_t i = 0; i != 256; ++i)
+    {
+      fe k;
+      [[maybe_unused]] const bool ok = fe_from_bytes(k, &priv[i * secp256k1::privkey_size]);
+      assert(ok);
+
+      std::byte ref[secp256k1::pubkey_size];
+      secp256k1::to_compressed(secp256k1::from_jacobian(secp256k1::windowed_scalar_mul(G_fe_precomp, fe_to_ix(k))), ref);
+      assert(std::equal(ref, ref + secp256k1::pubkey_size, &pub[i * secp256k1::pubkey_size]));
+    }
+    const auto t2 = std::chrono::steady_clock::now();
+
+    std::cout << "bulk keygen: " << static_cast<std::uint64_t>(count / std::chrono::duration<double>(t1 - t0).count())
+              << " keys/sec, one at a time: " << static_cast<std::uint64_t>(256 / std::chrono::duration<double>(t2 - t1).count())
+              << " keys/sec\n";
+  }
+
+  // ephemeral key for a handshake: pooled vs computed inline
+  {
+    static constexpr std::size_t runs = 2000;
+
+    const auto G_fe_precomp = secp256k1::precompute(secp256k1::to_jacobian(secp256k1::G));
+
+    secp256k1::key_pool pool(4096);
+    assert(pool.size() == pool.capacity());
+
+    std::vector<secp256k1::key_pair> taken(runs);
+    std::vector<std::uint64_t> pooled(runs), inline_ns(runs);
+
+    for (std::size_t i = 0; i != runs; ++i)
+    {
+      const auto t0 = std::chrono::steady_clock::now();
+      taken[i]      = pool.take();
+      const auto t1 = std::chrono::steady_clock::now();
+      pooled[i]     = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    }
+
+    for (std::size_t i = 0; i != runs; ++i)
+    {
+      const auto t0 = std::chrono::steady_clock::now();
+      secp256k1::key_pair kp;
+      secp256k1::bulk_keygen(kp.priv, kp.pub, 1);
+      const auto t1 = std::chrono::steady_clock::now();
+      inline_ns[i]  = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    }
+
+    // handed out keys are valid and never repeat
+    for (std::size_t i = 0; i + 1 < runs; i += 97)
+    {
+      fe k;
+      [[maybe_unused]] const bool ok = fe_from_bytes(k, taken[i].priv.data());
+      assert(ok);
+
+      std::byte ref[secp256k1::pubkey_size];
+      secp256k1::to_compressed(secp256k1::from_jacobian(secp256k1::windowed_scalar_mul(G_fe_precomp, fe_to_ix(k))), ref);
+      assert(std::equal(ref, ref + secp256k1::pubkey_size, taken[i].pub.begin()));
+      assert(taken[i].priv != taken[i + 1].priv);
+    }
+
+    std::sort(pooled.begin(), pooled.end());
+    std::sort(inline_ns.begin(), inline_ns.end());
+    std::cout << "ephemeral key pooled: p50 " << pooled[runs / 2] << " ns, p99 " << pooled[runs * 99 / 100] << " ns, misses "
+              << pool.misses() << "\n";
+    std::cout << "ephemeral key inline: p50 " << inline_ns[runs / 2] << " ns, p99 " << inline_ns[runs * 99 / 100] << " ns\n";
+  }
+
+  // scalars mod n against gmp
+  {
+    const ix order = "0xFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141";
+
+    std::vector<ix> vals = {0, 1, 2, order - 1, order - 2, ix{"0xFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF"} % order};
+    for (int i = 1; i != 40; ++i)
+    {
+      vals.push_back((privKeyA * i * i + privKeyB * (i * 7919)) % order);
+    }
+
+    for (const auto& x : vals)
+    {
+      const sc a = sc_from_ix(x);
+      assert(sc_to_ix(a) == x);
+
+      std::byte bytes[32];
+      sc_to_bytes(a, bytes);
+      sc back;
+      [[maybe_unused]] const bool canonical = sc_from_bytes(back, bytes);
+      assert(canonical && back == a);
+
+      if (x != 0)
+      {
+        assert(sc_mul(sc_inv(a), a) == sc_one);
+        assert(sc_to_ix(sc_inv(a)) == (modinv(x, order) + order) % order);
+      }
+
+      for (const auto& y : vals)
+      {
+        const sc b = sc_from_ix(y);
+        assert(sc_to_ix(sc_mul(a, b)) == x * y % order);
+        assert(sc_to_ix(sc_add(a, b)) == (x + y) % order);
+        assert(sc_to_ix(sc_sub(a, b)) == ((x - y) % order + order) % order);
+      }
+      assert(sc_to_ix(sc_sqr(a)) == x * x % order);
+    }
+
+    // 2^256 - 1 is >= n, flagged and reduced
+    std::byte ones[32];
+    std::fill(std::begin(ones), std::end(ones), std::byte{0xff});
+    sc reduced;
+    [[maybe_unused]] const bool canonical = sc_from_bytes(reduced, ones);
+    assert(!canonical && sc_to_ix(reduced) == ix{"0xFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF"} % order);
+
+    // the sc hooks give the same points as the GmpWrapper ones
+    const auto G_fe_precomp = secp256k1::precompute(secp256k1::to_jacobian(secp256k1::G));
+    assert(secp256k1::point_eq(secp256k1::windowed_scalar_mul(G_fe_precomp, sc_from_ix(privKeyA)),
+                               secp256k1::windowed_scalar_mul(G_fe_precomp, privKeyA)));
+
+    // the constant time variable base mul agrees with it, zero digits, k = 0 and k = n - 1 included
+    for (const ix& k : {ix{0}, ix{1}, ix{16}, ix{0x1000f}, order - 1, privKeyA, privKeyB, (privKeyA * privKeyB) % order})
+    {
+      assert(secp256k1::point_eq(secp256k1::windowed_scalar_mul_ct(G_fe_precomp, sc_from_ix(k)),
+                                 secp256k1::windowed_scalar_mul(G_fe_precomp, sc_from_ix(k))));
+    }
+
+    sc acc = sc_from_ix(privKeyA);
+    ix acc_ref = privKeyA;
+    {
+      perf_ _("10000x sc_mul");
+      for (int i = 0; i != 10000; ++i)
+      {
+        sc_mul(acc, acc, acc);
+      }
+    }
+    {
+      perf_ _("10000x mpz mul mod n");
+      for (int i = 0; i != 10000; ++i)
+      {
+        acc_ref = acc_ref * acc_ref % order;
+      }
+    }
+    assert(sc_to_ix(acc) == acc_ref);
+
+    {
+      perf_ _("1000x sc_inv");
+      for (int i = 0; i != 1000; ++i)
+      {
+        acc = sc_add(sc_inv(acc), sc_one);
+      }
+    }
+    {
+      perf_ _("1000x modinv mod n");
+      for (int i = 0; i != 1000; ++i)
+      {
+        acc_ref = (modinv(acc_ref, order) + order + 1) % order;
+      }
+    }
+    assert(sc_to_ix(acc) == acc_ref);
+  }
+
+  // sha256 / hmac / rfc 6979 / ecdsa sign
+  {
+    const auto bytes_of = [](std::string_view _s) { return std::as_bytes(std::span{_s.data(), _s.size()}); };
+    const auto hex_of   = [](std::span<const std::byte> _b)
+    {
+      static constexpr char digits[] = "0123456789abcdef";
+      std::string out;
+      for (const std::byte b : _b)
+      {
+        out += digits[std::to_integer<int>(b) >> 4];
+        out += digits[std::to_integer<int>(b) & 0xf];
+      }
+      return out;
+    };
+
+    assert(hex_of(sha256::hash(bytes_of(""))) == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    assert(hex_of(sha256::hash(bytes_of("abc"))) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    assert(hex_of(sha256::hash(bytes_of("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"))) ==
+           "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    assert(hex_of(hmac_sha256::mac(bytes_of("Jefe"), bytes_of("what do ya want for nothing?"))) ==
+           "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+
+    // streaming in odd pieces gives the same digest
+    std::string long_msg(1000, 'a');
+    sha256 pieces;
+    for (std::size_t i = 0; i < long_msg.size(); i += 37)
+    {
+      pieces.update(bytes_of(std::string_view{long_msg}.substr(i, 37)));
+    }
+    assert(pieces.finalize() == sha256::hash(bytes_of(long_msg)));
+
+    // d = 1, "Satoshi Nakamoto"
+    const auto satoshi = sha256::hash(bytes_of("Satoshi Nakamoto"));
+    assert(sc_to_ix(secp256k1::rfc6979(sc_one, satoshi.data()).next()) == ix{"0x8F8A276C19F4149656B280621E358CCE24F5F52542772691EE69063B74F15D15"});
+
+    std::byte compact[64];
+    secp256k1::to_compact(secp256k1::ecdsa_sign(sc_one, satoshi.data()), compact);
+    assert(hex_of(compact) == "934b1ea10a4b3c1757e2b0c017d0b6143ce3c9a7e6a4a49860d7a6ab210ee3d8"
+                              "2442ce9d2b916064108014783e923ec36b49743e2ffa1c4496f01a512aafd9e5");
+
+    static constexpr std::size_t batch = 1024;
+
+    std::vector<sc> privs;
+    std::vector<sha256_digest> hashes;
+    for (std::size_t i = 0; i != batch; ++i)
+    {
+      privs.push_back(sc_from_ix(privKeyA * (int)(i + 1) + privKeyB));
+      hashes.push_back(sha256::hash(bytes_of("message " + std::to_string(i))));
+    }
+
+    std::vector<secp256k1::ecdsa_sig> single(batch), batched(batch);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != batch; ++i)
+    {
+      single[i] = secp256k1::ecdsa_sign(privs[i], hashes[i].data());
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    secp256k1::ecdsa_sign_batch(privs, hashes, batched);
+    const auto t2 = std::chrono::steady_clock::now();
+
+    assert(single == batched);
+
+    // s k == z + r d and r == x(kG) mod n, checked with gmp
+    const ix order = "0xFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141";
+    for (std::size_t i = 0; i < batch; i += 101)
+    {
+      const sc k = secp256k1::rfc6979(privs[i], hashes[i].data()).next();
+      sc z;
+      sc_from_bytes(z, hashes[i].data());
+
+      const ix kx = from_jacobian(windowed_scalar_mul(G_precomp, sc_to_ix(k), mod_global), mod_global).x;
+      const ix s  = sc_to_ix(single[i].s);
+      assert(sc_to_ix(single[i].r) == kx % order);
+      assert(s * sc_to_ix(k) % order == (sc_to_ix(z) + sc_to_ix(single[i].r) * sc_to_ix(privs[i])) % order ||
+             (order - s) * sc_to_ix(k) % order == (sc_to_ix(z) + sc_to_ix(single[i].r) * sc_to_ix(privs[i])) % order);
+      assert(!sc_is_high(single[i].s));
+    }
+
+    std::cout << "ecdsa sign: " << static_cast<std::uint64_t>(batch / std::chrono::duration<double>(t1 - t0).count())
+              << " sigs/sec, batched: " << static_cast<std::uint64_t>(batch / std::chrono::duration<double>(t2 - t1).count())
+              << " sigs/sec\n";
+  }
+
+  // ecdsa verify: joint multiply + projective r check vs two muls and from_jacobian
+  {
+    const auto bytes_of = [](std::string_view _s) { return std::as_bytes(std::span{_s.data(), _s.size()}); };
+
+    static constexpr std::size_t batch = 512;
+
+    const auto G_fe_precomp = secp256k1::precompute(secp256k1::to_jacobian(secp256k1::G));
+
+    std::vector<secp256k1::crv_p> pubs;
+    std::vector<sha256_digest> hashes;
+    std::vector<secp256k1::ecdsa_sig> sigs;
+    for (std::size_t i = 0; i != batch; ++i)
+    {
+      const sc d = sc_from_ix(privKeyB * (int)(i + 3) + privKeyA);
+      pubs.push_back(secp256k1::from_jacobian(secp256k1::windowed_scalar_mul(G_fe_precomp, d)));
+      hashes.push_back(sha256::hash(bytes_of("verify " + std::to_string(i))));
+      sigs.push_back(secp256k1::ecdsa_sign(d, hashes.back().data()));
+    }
+
+    // textbook: two separate muls, affine x
+    const auto verify_ref = [&](std::size_t i)
+    {
+      sc z;
+      sc_from_bytes(z, hashes[i].data());
+      const sc w = sc_inv(sigs[i].s);
+
+      const auto u1G = secp256k1::windowed_scalar_mul(G_fe_precomp, sc_mul(z, w));
+      const auto u2Q = secp256k1::windowed_scalar_mul(secp256k1::precompute(secp256k1::to_jacobian(pubs[i])), sc_mul(sigs[i].r, w));
+      return sc_from_fe(secp256k1::from_jacobian(secp256k1::point_add(u1G, u2Q)).x) == sigs[i].r;
+    };
+
+    std::size_t ok_ref = 0, ok_joint = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != batch; ++i)
+    {
+      ok_ref += verify_ref(i);
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != batch; ++i)
+    {
+      ok_joint += secp256k1::ecdsa_verify(pubs[i], hashes[i].data(), sigs[i]);
+    }
+    const auto t2 = std::chrono::steady_clock::now();
+
+    assert(ok_ref == batch && ok_joint == batch);
+
+    // wrong message, wrong key, tweaked r / s, zero r all fail
+    assert(!secp256k1::ecdsa_verify(pubs[0], hashes[1].data(), sigs[0]));
+    assert(!secp256k1::ecdsa_verify(pubs[1], hashes[0].data(), sigs[0]));
+    assert(!secp256k1::ecdsa_verify(pubs[0], hashes[0].data(), {sc_add(sigs[0].r, sc_one), sigs[0].s}));
+    assert(!secp256k1::ecdsa_verify(pubs[0], hashes[0].data(), {sigs[0].r, sc_add(sigs[0].s, sc_one)}));
+    assert(!secp256k1::ecdsa_verify(pubs[0], hashes[0].data(), {sc_zero, sigs[0].s}));
+    // high s is the same signature as far as plain ecdsa goes
+    assert(secp256k1::ecdsa_verify(pubs[0], hashes[0].data(), {sigs[0].r, sc_neg(sigs[0].s)}));
+
+    std::cout << "ecdsa verify: " << static_cast<std::uint64_t>(batch / std::chrono::duration<double>(t2 - t1).count())
+              << " verifies/sec, two muls + affine: " << static_cast<std::uint64_t>(batch / std::chrono::duration<double>(t1 - t0).count())
+              << " verifies/sec\n";
+  }
+
+  // ecdsa batch verify with R hints, msm + random weights vs one ecdsa_verify per signature
+  {
+    const auto bytes_of = [](std::string_view _s) { return std::as_bytes(std::span{_s.data(), _s.size()}); };
+
+    static constexpr std::size_t max_batch = 65536;
+    static constexpr std::size_t key_count = 256;
+
+    std::vector<sc> key_privs;
+    std::vector<std::array<std::uint64_t, 4>> key_limbs;
+    for (std::size_t i = 0; i != key_count; ++i)
+    {
+      key_privs.push_back(sc_from_ix(privKeyA * (int)(i + 17) + privKeyB));
+      key_limbs.push_back({key_privs.back().n[0], key_privs.back().n[1], key_privs.back().n[2], key_privs.back().n[3]});
+    }
+    std::vector<secp256k1::crv_p> key_pubs(key_count);
+    secp256k1::fixed_base_mul_many(key_limbs, key_pubs);
+
+    std::vector<sc> privs(max_batch);
+    std::vector<secp256k1::crv_p> pubs(max_batch);
+    std::vector<sha256_digest> hashes(max_batch);
+    for (std::size_t i = 0; i != max_batch; ++i)
+    {
+      privs[i]  = key_privs[i % key_count];
+      pubs[i]   = key_pubs[i % key_count];
+      hashes[i] = sha256::hash(bytes_of("batch " + std::to_string(i)));
+    }
+
+    std::vector<secp256k1::ecdsa_sig> sigs(max_batch);
+    std::vector<std::uint8_t> recids(max_batch), valid(max_batch);
+    secp256k1::ecdsa_sign_batch(privs, hashes, sigs, recids);
+
+    // the single signer gives the same hint
+    std::uint8_t recid0;
+    assert(secp256k1::ecdsa_sign(privs[0], hashes[0].data(), &recid0) == sigs[0] && recid0 == recids[0]);
+
+    double single_us = 0;
+    {
+      const auto t0 = std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i != 256; ++i)
+      {
+        valid[i] = secp256k1::ecdsa_verify(pubs[i], hashes[i].data(), sigs[i]);
+      }
+      single_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / 256;
+      assert(std::all_of(valid.begin(), valid.begin() + 256, [](std::uint8_t v) { return v == 1; }));
+    }
+
+    for (const std::size_t batch : {16, 64, 256, 1024, 4096, 16384, 65536})
+    {
+      const auto t0 = std::chrono::steady_clock::now();
+      [[maybe_unused]] const bool all =
+          secp256k1::ecdsa_verify_batch(std::span{pubs}.first(batch), std::span{hashes}.first(batch), std::span{sigs}.first(batch),
+                                        std::span{recids}.first(batch), std::span{valid}.first(batch));
+      const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / batch;
+      assert(all);
+
+      std::cout << "ecdsa batch verify " << batch << ": " << us << " us/sig, single " << single_us << " us/sig\n";
+    }
+
+    // public key recovery, one by one vs shared inversions
+    {
+      static constexpr std::size_t recover_batch = 1024;
+
+      std::vector<secp256k1::crv_p> recovered(recover_batch);
+
+      const auto t0 = std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i != recover_batch; ++i)
+      {
+        [[maybe_unused]] const bool ok = secp256k1::ecdsa_recover(recovered[i], hashes[i].data(), sigs[i], recids[i]);
+        assert(ok && recovered[i] == pubs[i]);
+      }
+      const auto t1 = std::chrono::steady_clock::now();
+      std::fill(recovered.begin(), recovered.end(), secp256k1::a_identity_element);
+      [[maybe_unused]] const bool all =
+          secp256k1::ecdsa_recover_batch(std::span{hashes}.first(recover_batch), std::span{sigs}.first(recover_batch),
+                                         std::span{recids}.first(recover_batch), recovered, std::span{valid}.first(recover_batch));
+      const auto t2 = std::chrono::steady_clock::now();
+
+      assert(all && std::equal(recovered.begin(), recovered.end(), pubs.begin()));
+
+      // the wrong parity gives some other key, a zero r gives none
+      secp256k1::crv_p other;
+      [[maybe_unused]] const bool flipped = secp256k1::ecdsa_recover(other, hashes[0].data(), sigs[0], recids[0] ^ 1);
+      assert(flipped && other != pubs[0]);
+      assert(!secp256k1::ecdsa_recover(other, hashes[0].data(), {sc_zero, sigs[0].s}, recids[0]));
+
+      std::cout << "ecdsa recover: " << std::chrono::duration<double, std::micro>(t1 - t0).count() / recover_batch
+                << " us/sig, batched: " << std::chrono::duration<double, std::micro>(t2 - t1).count() / recover_batch << " us/sig\n";
+    }
+
+    // a few bad ones in a batch of 1024 get found, the rest stay valid
+    std::vector<secp256k1::ecdsa_sig> broken(sigs.begin(), sigs.begin() + 1024);
+    broken[3].s   = sc_add(broken[3].s, sc_one);
+    broken[500].r = sc_add(broken[500].r, sc_one);
+    broken[1023]  = broken[1022];
+
+    [[maybe_unused]] const bool all = secp256k1::ecdsa_verify_batch(std::span{pubs}.first(1024), std::span{hashes}.first(1024), broken,
+                                                                    std::span{recids}.first(1024), std::span{valid}.first(1024));
+    assert(!all);
+    for (std::size_t i = 0; i != 1024; ++i)
+    {
+      assert(valid[i] == (i != 3 && i != 500 && i != 1023));
+    }
+  }
+
+  // bip340 schnorr: spec vectors, then batch verify through one msm vs schnorr_verify per signature
+  {
+    const auto bytes_of  = [](std::string_view _s) { return std::as_bytes(std::span{_s.data(), _s.size()}); };
+    const auto from_hex = [](std::string_view _h)
+    {
+      std::vector<std::byte> out;
+      for (std::size_t i = 0; i + 1 < _h.size(); i += 2)
+      {
+        out.push_back(static_cast<std::byte>(std::stoi(std::string{_h.substr(i, 2)}, nullptr, 16)));
+      }
+      return out;
+    };
+
+    struct vector_case
+    {
+      const char *priv, *pub, *aux, *msg, *sig;
+    };
+    static constexpr vector_case vectors[] = {
+        {"0000000000000000000000000000000000000000000000000000000000000003",
+         "F9308A019258C31049344F85F89D5229B531C845836F99B08601F113BCE036F9",
+         "0000000000000000000000000000000000000000000000000000000000000000",
+         "0000000000000000000000000000000000000000000000000000000000000000",
+         "E907831F80848D1069A5371B402410364BDF1C5F8307B0084C55F1CE2DCA8215"
+         "25F66A4A85EA8B71E482A74F382D2CE5EBEEE8FDB2172F477DF4900D310536C0"},
+        {"B7E151628AED2A6ABF7158809CF4F3C762E7160F38B4DA56A784D9045190CFEF",
+         "DFF1D77F2A671C5F36183726DB2341BE58FEAE1DA2DECED843240F7B502BA659",
+         "0000000000000000000000000000000000000000000000000000000000000001",
+         "243F6A8885A308D313198A2E03707344A4093822299F31D0082EFA98EC4E6C89",
+         "6896BD60EEAE296DB48A229FF71DFE071BDE413E6D43F917DC8DCF8C78DE3341"
+         "8906D11AC976ABCCB20B091292BFF4EA897EFCB639EA871CFA95F6DE339E4B0A"},
+    };
+
+    for (const auto& v : vectors)
+    {
+      const auto priv = from_hex(v.priv), pub = from_hex(v.pub), aux = from_hex(v.aux), msg = from_hex(v.msg), sig = from_hex(v.sig);
+
+      sc d;
+      sc_from_bytes(d, priv.data());
+
+      secp256k1::crv_p P;
+      [[maybe_unused]] const bool lifted = secp256k1::xonly_from_bytes(P, pub.data());
+      assert(lifted && secp256k1::xonly_pubkey(d) == P);
+
+      std::byte compact[64];
+      secp256k1::schnorr_sig mine;
+      [[maybe_unused]] const bool signed_ok = secp256k1::schnorr_sign(mine, d, msg.data(), aux.data());
+      secp256k1::to_compact(mine, compact);
+      assert(signed_ok && std::equal(sig.begin(), sig.end(), compact));
+
+      secp256k1::schnorr_sig parsed;
+      [[maybe_unused]] const bool in_range = secp256k1::from_compact(parsed, sig.data());
+      assert(in_range && secp256k1::schnorr_verify(P, msg.data(), parsed));
+    }
+
+    static constexpr std::size_t max_batch = 4096;
+    static constexpr std::size_t key_count = 64;
+
+    std::vector<secp256k1::crv_p> key_pubs;
+    std::vector<sc> key_privs;
+    for (std::size_t i = 0; i != key_count; ++i)
+    {
+      key_privs.push_back(sc_from_ix(privKeyB * (int)(i + 29) + privKeyA));
+      key_pubs.push_back(secp256k1::xonly_pubkey(key_privs.back()));
+    }
+
+    std::vector<secp256k1::crv_p> pubs(max_batch);
+    std::vector<sha256_digest> msgs(max_batch);
+    std::vector<secp256k1::schnorr_sig> sigs(max_batch);
+    std::vector<std::uint8_t> valid(max_batch);
+    for (std::size_t i = 0; i != max_batch; ++i)
+    {
+      const auto aux = sha256::hash(bytes_of("aux " + std::to_string(i)));
+      pubs[i]        = key_pubs[i % key_count];
+      msgs[i]        = sha256::hash(bytes_of("schnorr " + std::to_string(i)));
+      [[maybe_unused]] const bool signed_ok = secp256k1::schnorr_sign(sigs[i], key_privs[i % key_count], msgs[i].data(), aux.data());
+      assert(signed_ok);
+    }
+    std::byte zero_aux[32]{};
+    assert(!secp256k1::schnorr_sign(sigs[1], sc_zero, msgs[1].data(), zero_aux));
+
+    // wrong message, wrong key, tweaked r / s, r not on the curve all fail
+    assert(!secp256k1::schnorr_verify(pubs[0], msgs[1].data(), sigs[0]));
+    assert(!secp256k1::schnorr_verify(pubs[1], msgs[0].data(), sigs[0]));
+    assert(!secp256k1::schnorr_verify(pubs[0], msgs[0].data(), {fe_add(sigs[0].r, fe_one), sigs[0].s}));
+    assert(!secp256k1::schnorr_verify(pubs[0], msgs[0].data(), {sigs[0].r, sc_add(sigs[0].s, sc_one)}));
+    // the odd y twin of the key
+    assert(!secp256k1::schnorr_verify({pubs[0].x, fe_neg(pubs[0].y)}, msgs[0].data(), sigs[0]));
+
+    double single_us = 0;
+    {
+      const auto t0 = std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i != 256; ++i)
+      {
+        valid[i] = secp256k1::schnorr_verify(pubs[i], msgs[i].data(), sigs[i]);
+      }
+      single_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / 256;
+      assert(std::all_of(valid.begin(), valid.begin() + 256, [](std::uint8_t v) { return v == 1; }));
+    }
+
+    for (const std::size_t batch : {16, 64, 256, 1024, 4096})
+    {
+      const auto t0 = std::chrono::steady_clock::now();
+      [[maybe_unused]] const bool all = secp256k1::schnorr_verify_batch(std::span{pubs}.first(batch), std::span{msgs}.first(batch),
+                                                                       std::span{sigs}.first(batch), std::span{valid}.first(batch));
+      const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / batch;
+      assert(all);
+
+      std::cout << "schnorr batch verify " << batch << ": " << us << " us/sig, single " << single_us << " us/sig\n";
+    }
+
+    std::vector<secp256k1::schnorr_sig> broken(sigs.begin(), sigs.begin() + 256);
+    broken[7].s   = sc_add(broken[7].s, sc_one);
+    broken[100].r = fe_add(broken[100].r, fe_one);
+    broken[255]   = broken[254];
+
+    [[maybe_unused]] const bool all =
+        secp256k1::schnorr_verify_batch(std::span{pubs}.first(256), std::span{msgs}.first(256), broken, std::span{valid}.first(256));
+    assert(!all);
+    for (std::size_t i = 0; i != 256; ++i)
+    {
+      assert(valid[i] == (i != 7 && i != 100 && i != 255));
+    }
+  }
+
+  // sec1 encode / decode, one lift_x per key vs the roots of a whole batch through fe_sqrt_many
+  {
+    const auto hex_of = [](std::span<const std::byte> _b)
+    {
+      static constexpr char digits[] = "0123456789ABCDEF";
+      std::string out;
+      for (const std::byte b : _b)
+      {
+        out += digits[std::to_integer<int>(b) >> 4];
+        out += digits[std::to_integer<int>(b) & 0xf];
+      }
+      return out;
+    };
+
+    std::array<std::byte, secp256k1::sec1_compressed_size> c;
+    std::array<std::byte, secp256k1::sec1_uncompressed_size> u;
+    [[maybe_unused]] const bool enc_c = secp256k1::sec1_encode(secp256k1::G, c);
+    [[maybe_unused]] const bool enc_u = secp256k1::sec1_encode(secp256k1::G, u);
+    assert(enc_c && hex_of(c) == "0279BE667EF9DCBBAC55A06295CE870B07029BFCDB2DCE28D959F2815B16F81798");
+    assert(enc_u && hex_of(u) == "0479BE667EF9DCBBAC55A06295CE870B07029BFCDB2DCE28D959F2815B16F81798"
+                                 "483ADA7726A3C4655DA4FBFC0E1108A8FD17B448A68554199C47D08FFB10D4B8");
+    assert(!secp256k1::sec1_encode(secp256k1::a_identity_element, c));
+    assert(!secp256k1::sec1_encode(secp256k1::G, std::span{u}.first(64)));
+
+    secp256k1::crv_p P;
+    assert(secp256k1::sec1_decode(P, c) && P == secp256k1::G);
+    assert(secp256k1::sec1_decode(P, u) && P == secp256k1::G);
+
+    // bad prefix, hybrid form, y off the curve, x >= p, x without a point, wrong length
+    c[0] = std::byte{0x04};
+    assert(!secp256k1::sec1_decode(P, c));
+    u[0] = std::byte{0x06};
+    assert(!secp256k1::sec1_decode(P, u));
+    u[0] = std::byte{0x04};
+    u[64] ^= std::byte{1};
+    assert(!secp256k1::sec1_decode(P, u));
+    c[0] = std::byte{0x02};
+    std::fill(c.begin() + 1, c.end(), std::byte{0xff});
+    assert(!secp256k1::sec1_decode(P, c));
+    std::fill(c.begin() + 1, c.end(), std::byte{0});
+    for (c.back() = std::byte{1}; secp256k1::sec1_decode(P, c); c.back() = std::byte(std::to_integer<int>(c.back()) + 1))
+    {
+    }
+    assert(!secp256k1::sec1_decode(P, std::span{u}.first(33)));
+
+    static constexpr std::size_t keys = 4096;
+
+    std::vector<std::byte> priv(keys * secp256k1::privkey_size), pub(keys * secp256k1::pubkey_size);
+    secp256k1::bulk_keygen(priv, pub, 1);
+
+    std::vector<secp256k1::crv_p> one(keys), many(keys);
+    std::vector<std::uint8_t> valid(keys);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != keys; ++i)
+    {
+      [[maybe_unused]] const bool ok = secp256k1::sec1_decode(one[i], std::span{pub}.subspan(i * 33, 33));
+      assert(ok);
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    [[maybe_unused]] const bool all = secp256k1::sec1_decode_many(pub, many, valid);
+    const auto t2 = std::chrono::steady_clock::now();
+
+    assert(all && one == many);
+
+    // round trip both forms, and a broken entry in a batch only fails itself
+    std::vector<std::byte> again(keys * 65);
+    for (std::size_t i = 0; i != keys; ++i)
+    {
+      secp256k1::sec1_encode(many[i], std::span{again}.subspan(i * 65, 65));
+      assert(std::equal(pub.begin() + i * 33 + 1, pub.begin() + i * 33 + 33, again.begin() + i * 65 + 1));
+    }
+    assert(secp256k1::sec1_decode_many(again, many, valid) && one == many);
+
+    pub[5 * 33] = std::byte{0x05};
+    assert(!secp256k1::sec1_decode_many(pub, many, valid));
+    for (std::size_t i = 0; i != keys; ++i)
+    {
+      assert(valid[i] == (i != 5) && (i == 5 ? many[i] == secp256k1::a_identity_element : many[i] == one[i]));
+    }
+
+    std::cout << "sec1 decode (" << secp256k1::lane_backend_name(secp256k1::lane_kernel)
+              << "): " << std::chrono::duration<double, std::micro>(t1 - t0).count() / keys
+              << " us/key, batched: " << std::chrono::duration<double, std::micro>(t2 - t1).count() / keys << " us/key\n";
+  }
+
+  // GmpWrapper byte / hex marshalling straight off the limbs vs mpz_get_str
+  {
+    const ix v = "0x0102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f20";
+
+    std::array<std::byte, 32> be, le;
+    [[maybe_unused]] const bool fits_be = v.to_bytes(be);
+    [[maybe_unused]] const bool fits_le = v.to_bytes(le, std::endian::little);
+    assert(fits_be && fits_le);
+    for (std::size_t i = 0; i != 32; ++i)
+    {
+      assert(std::to_integer<std::size_t>(be[i]) == i + 1 && le[31 - i] == be[i]);
+    }
+    assert(ix::from_bytes(be) == v && ix::from_bytes(le, std::endian::little) == v);
+
+    // zero padding, too small a buffer, zero
+    std::array<std::byte, 40> wide;
+    assert(v.to_bytes(wide) && ix::from_bytes(wide) == v && wide[0] == std::byte{0} && wide[8] == std::byte{1});
+    assert(!v.to_bytes(std::span{be}.first(31)));
+    assert(ix{0}.to_bytes(be) && std::all_of(be.begin(), be.end(), [](std::byte b) { return b == std::byte{0}; }));
+    assert(ix::from_bytes({}) == 0);
+
+    std::array<char, 66> hex;
+    assert(v.to_hex(hex) && std::string_view(hex.data(), hex.size()) ==
+                                "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f20");
+    assert(v.to_hex(std::span{hex}.first(63)) && !v.to_hex(std::span{hex}.first(62)));
+    assert(ix{255}.to_hex(std::span{hex}.first(2)) && hex[0] == 'f' && hex[1] == 'f');
+
+    // operator<< (decimal) round trips through the string constructor
+    std::ostringstream os;
+    os << v;
+    assert(ix{os.str().c_str()} == v);
+
+    static constexpr std::size_t runs = 1 << 16;
+
+    std::vector<ix> keys;
+    for (std::size_t i = 0; i != 256; ++i)
+    {
+      keys.push_back(privKeyA * (int)(i + 1) + privKeyB);
+    }
+
+    std::size_t sink = 0;
+    const auto t0    = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != runs; ++i)
+    {
+      std::ostringstream dec;
+      dec << keys[i % keys.size()];
+      sink += dec.str()[0];
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != runs; ++i)
+    {
+      keys[i % keys.size()].to_hex(std::span{hex}.first(64));
+      sink += hex[0];
+    }
+    const auto t2 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != runs; ++i)
+    {
+      keys[i % keys.size()].to_bytes(be);
+      sink += std::to_integer<std::size_t>(be[0]);
+    }
+    const auto t3 = std::chrono::steady_clock::now();
+
+    std::cout << "key marshalling: operator<< " << std::chrono::duration<double, std::nano>(t1 - t0).count() / runs << " ns, to_hex "
+              << std::chrono::duration<double, std::nano>(t2 - t1).count() / runs << " ns, to_bytes "
+              << std::chrono::duration<double, std::nano>(t3 - t2).count() / runs << " ns (" << sink % 2 << ")\n";
+  }
+
+  // hex codec: every kernel against the table, then bulk key ingest vs the GmpWrapper string constructor
+  {
+    using decode_fn = bool (*)(const char*, std::byte*, std::size_t) noexcept;
+    using encode_fn = void (*)(const std::byte*, char*, std::size_t) noexcept;
+
+    std::vector<std::pair<decode_fn, encode_fn>> kernels = {{detail::hex_decode_scalar, detail::hex_encode_scalar}};
+    if (hex_kernel.ssse3)
+    {
+      kernels.push_back({detail::hex_decode_ssse3, detail::hex_encode_ssse3});
+    }
+    if (hex_kernel.avx2)
+    {
+      kernels.push_back({detail::hex_decode_avx2, detail::hex_encode_avx2});
+    }
+
+    os_random rng;
+    std::vector<std::byte> raw(100), back(100);
+    std::vector<char> text(200), ref(200);
+    for (const auto& [dec, enc] : kernels)
+    {
+      // every length through the vector bodies and the tails, encode matches the table and decodes back
+      for (std::size_t len = 0; len <= raw.size(); ++len)
+      {
+        rng.fill(std::span{raw}.first(len));
+        enc(raw.data(), text.data(), len);
+        detail::hex_encode_scalar(raw.data(), ref.data(), len);
+        assert(std::equal(text.begin(), text.begin() + 2 * len, ref.begin()));
+
+        std::transform(text.begin(), text.begin() + 2 * len, text.begin(), [&](char c) { return rng.next_u64() & 1 ? std::toupper(c) : c; });
+        [[maybe_unused]] const bool ok = dec(text.data(), back.data(), len);
+        assert(ok && std::equal(raw.begin(), raw.begin() + len, back.begin()));
+      }
+
+      // every byte value at every position of a 48 digit run, only hex digits pass
+      for (std::size_t pos = 0; pos != 48; ++pos)
+      {
+        for (int c = 0; c != 256; ++c)
+        {
+          std::fill(text.begin(), text.begin() + 48, '7');
+          text[pos] = static_cast<char>(c);
+          assert(dec(text.data(), back.data(), 24) == (detail::hex_values.v[c] != 0xff));
+        }
+      }
+    }
+
+    // 2^18 keys of 64 digits, one per line
+    static constexpr std::size_t keys   = 1 << 18;
+    static constexpr std::size_t stride = 65;
+
+    std::vector<std::byte> key_bytes(keys * 32);
+    rng.fill(key_bytes);
+
+    std::vector<char> file(keys * stride, '\n');
+    for (std::size_t k = 0; k != keys; ++k)
+    {
+      hex_encode(std::span{key_bytes}.subspan(k * 32, 32), std::span{file}.subspan(k * stride, 64));
+    }
+
+    std::vector<std::uint64_t> limbs(keys * 4);
+    std::vector<std::uint8_t> valid(keys);
+
+    const auto t0                   = std::chrono::steady_clock::now();
+    [[maybe_unused]] const bool all = hex_decode_keys(file, 32, stride, limbs, valid);
+    const auto t1                   = std::chrono::steady_clock::now();
+    assert(all);
+
+    std::vector<char> again(keys * 64);
+    const auto t2 = std::chrono::steady_clock::now();
+    hex_encode(key_bytes, again);
+    const auto t3 = std::chrono::steady_clock::now();
+
+    // the string constructor on a slice of the same keys
+    static constexpr std::size_t gmp_keys = 1 << 14;
+    std::vector<std::string> prefixed;
+    for (std::size_t k = 0; k != gmp_keys; ++k)
+    {
+      prefixed.push_back("0x" + std::string(&file[k * stride], 64));
+    }
+    std::size_t sink = 0;
+    const auto t4    = std::chrono::steady_clock::now();
+    for (std::size_t k = 0; k != gmp_keys; ++k)
+    {
+      sink += ix{prefixed[k].c_str()}.bitlength();
+    }
+    const auto t5 = std::chrono::steady_clock::now();
+
+    for (std::size_t k = 0; k < keys; k += 997)
+    {
+      assert(ix::from_limbs(&limbs[4 * k], 4) == ix::from_bytes(std::span{key_bytes}.subspan(k * 32, 32)));
+      assert(ix{prefixed[k % gmp_keys].c_str()} == ix::from_limbs(&limbs[4 * (k % gmp_keys)], 4));
+    }
+
+    // a bad digit only fails its own key
+    file[5 * stride + 17] = 'g';
+    assert(!hex_decode_keys(file, 32, stride, limbs, valid));
+    assert(std::count(valid.begin(), valid.end(), 0) == 1 && valid[5] == 0);
+
+    const auto gbps = [](std::size_t _bytes, auto _d) { return _bytes / std::chrono::duration<double>(_d).count() / 1e9; };
+    std::cout << "hex (" << hex_kernel.name << "): decode keys " << gbps(file.size(), t1 - t0) << " GB/s, encode "
+              << gbps(again.size(), t3 - t2) << " GB/s, GmpWrapper(const char*) " << gbps(gmp_keys * 66, t5 - t4) << " GB/s ("
+              << sink % 2 << ")\n";
+  }
+
+  // peer key validation: bitmap over a batch vs y^2 == x^3 + 7 in GmpWrapper per key
+  {
+    static constexpr std::size_t keys = 4096;
+
+    std::vector<std::byte> priv(keys * secp256k1::privkey_size), pub(keys * secp256k1::pubkey_size);
+    secp256k1::bulk_keygen(priv, pub, 1);
+
+    std::vector<secp256k1::crv_p> peers(keys);
+    std::vector<std::uint64_t> bitmap(secp256k1::bitmap_words(keys));
+    [[maybe_unused]] const std::size_t decoded = secp256k1::validate_sec1(pub, peers, bitmap);
+    assert(decoded == keys);
+
+    // a small x with a point on it, so x + p still fits in 256 bits
+    fe small = fe_one;
+    while (!secp256k1::lift_x(peers[63], small, false))
+    {
+      small = fe_add(small, fe_one);
+    }
+
+    // off the curve, x >= p (x mod p is on the curve), O, the negated point (valid), y = p - 1
+    peers[1].y        = fe_add(peers[1].y, fe_one);
+    peers[64]         = {{{small.n[0] + fe_p.n[0], fe_p.n[1], fe_p.n[2], fe_p.n[3]}}, peers[63].y};
+    peers[99]         = secp256k1::a_identity_element;
+    peers[100]        = {peers[100].x, fe_neg(peers[100].y)};
+    peers[keys - 1].y = fe_neg(fe_one);
+
+    const auto t0                         = std::chrono::steady_clock::now();
+    [[maybe_unused]] const std::size_t ok = secp256k1::validate_points(peers, bitmap);
+    const auto t1                         = std::chrono::steady_clock::now();
+
+    std::size_t ok_ref = 0;
+    for (std::size_t i = 0; i != keys; ++i)
+    {
+      const ix x = fe_to_ix(peers[i].x), y = fe_to_ix(peers[i].y);
+      const bool valid = (y * y) % mod_global == (x * x * x + 7) % mod_global && x < mod_global && y < mod_global && !(x == 0 && y == 0);
+      ok_ref += valid;
+      assert(valid == secp256k1::bitmap_test(bitmap, i));
+    }
+    const auto t2 = std::chrono::steady_clock::now();
+
+    assert(ok == ok_ref && ok == keys - 4 && secp256k1::bitmap_test(bitmap, 63) && secp256k1::bitmap_test(bitmap, 100) &&
+           !secp256k1::bitmap_test(bitmap, 64));
+
+    // filter a batch for ECDH in one pass over the bitmap
+    std::vector<secp256k1::crv_p> accepted;
+    for (std::size_t w = 0; w != bitmap.size(); ++w)
+    {
+      for (std::uint64_t bits = bitmap[w]; bits != 0; bits &= bits - 1)
+      {
+        accepted.push_back(peers[w * 64 + std::countr_zero(bits)]);
+      }
+    }
+    assert(accepted.size() == ok);
+
+    std::cout << "validate peer keys: " << std::chrono::duration<double, std::nano>(t1 - t0).count() / keys
+              << " ns/key, GmpWrapper: " << std::chrono::duration<double, std::nano>(t2 - t1).count() / keys << " ns/key\n";
+  }
+
+  // x only ECDH: X / Z^2 only, x only peer keys, one shared inversion for a batch
+  {
+    static constexpr std::size_t batch = 256;
+
+    const auto G_fe_precomp = secp256k1::precompute(secp256k1::to_jacobian(secp256k1::G));
+
+    std::vector<ix> scalars;
+    std::vector<sc> privs;
+    std::vector<secp256k1::crv_p> pubs;
+    std::vector<std::vector<secp256k1::jcbn_crv_p>> peers;
+    for (std::size_t i = 0; i != batch; ++i)
+    {
+      scalars.push_back((privKeyB * (int)(i + 5) + privKeyA) % mod_global);
+      privs.push_back(sc_from_ix(scalars.back()));
+      pubs.push_back(secp256k1::from_jacobian(secp256k1::windowed_scalar_mul(G_fe_precomp, privKeyA * (int)(i + 11) % mod_global)));
+      peers.push_back(secp256k1::precompute(secp256k1::to_jacobian(pubs.back())));
+    }
+
+    std::vector<const std::vector<secp256k1::jcbn_crv_p>*> peer_ptrs;
+    for (const auto& peer : peers)
+    {
+      peer_ptrs.push_back(&peer);
+    }
+
+    std::vector<secp256k1::crv_p> full(batch);
+    std::vector<fe> x_only(batch), x_many(batch), x_many_ct(batch);
+    std::vector<std::uint8_t> ok(batch), ok_ct(batch);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != batch; ++i)
+    {
+      full[i] = secp256k1::from_jacobian(secp256k1::windowed_scalar_mul(peers[i], scalars[i]));
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != batch; ++i)
+    {
+      secp256k1::ecdh_x(x_only[i], peers[i], scalars[i]);
+    }
+    const auto t2 = std::chrono::steady_clock::now();
+    secp256k1::ecdh_x_many(peer_ptrs, scalars, x_many, ok);
+    const auto t3 = std::chrono::steady_clock::now();
+    secp256k1::ecdh_x_many(peer_ptrs, privs, x_many_ct, ok_ct);
+    const auto t4 = std::chrono::steady_clock::now();
+
+    for (std::size_t i = 0; i != batch; ++i)
+    {
+      assert(ok[i] && x_only[i] == full[i].x && x_many[i] == full[i].x);
+      assert(ok_ct[i] && x_many_ct[i] == full[i].x);
+    }
+
+    // a zero scalar and an O peer give O in the constant time batch
+    {
+      const auto O_table = secp256k1::precompute(secp256k1::j_identity_element);
+      const std::vector<const std::vector<secp256k1::jcbn_crv_p>*> edge_ptrs{peer_ptrs[0], &O_table, peer_ptrs[1]};
+      const std::vector<sc> edge_k{sc_zero, privs[1], privs[1]};
+      std::vector<fe> edge_x(3);
+      std::vector<std::uint8_t> edge_ok(3);
+      secp256k1::ecdh_x_many(edge_ptrs, edge_k, edge_x, edge_ok);
+      assert(!edge_ok[0] && !edge_ok[1] && edge_ok[2] && edge_x[2] == full[1].x);
+    }
+
+    // 32 byte x only keys, either parity of the peer gives the same secret
+    std::byte peer_x[32], secret[32], secret_neg[32], expected[32];
+    fe_to_bytes(pubs[0].x, peer_x);
+    fe_to_bytes(full[0].x, expected);
+    [[maybe_unused]] const bool got = secp256k1::ecdh_xonly(secret, peer_x, privs[0]);
+    assert(got && std::equal(secret, secret + 32, expected));
+
+    fe x_neg;
+    [[maybe_unused]] const bool got_neg =
+        secp256k1::ecdh_x(x_neg, secp256k1::precompute(secp256k1::to_jacobian({pubs[0].x, fe_neg(pubs[0].y)})), privs[0]);
+    fe_to_bytes(x_neg, secret_neg);
+    assert(got_neg && std::equal(secret, secret + 32, secret_neg));
+
+    // both sides agree, x >= p and x off the curve are refused
+    std::byte a_x[32], b_x[32], ab[32], ba[32];
+    fe_to_bytes(secp256k1::xonly_pubkey(privs[1]).x, a_x);
+    fe_to_bytes(secp256k1::xonly_pubkey(privs[2]).x, b_x);
+    assert(secp256k1::ecdh_xonly(ab, b_x, privs[1]) && secp256k1::ecdh_xonly(ba, a_x, privs[2]) && std::equal(ab, ab + 32, ba));
+
+    std::fill(peer_x, peer_x + 32, std::byte{0xff});
+    assert(!secp256k1::ecdh_xonly(secret, peer_x, privs[0]));
+    std::fill(peer_x, peer_x + 32, std::byte{0});
+    secp256k1::crv_p probe;
+    for (peer_x[31] = std::byte{1}; secp256k1::lift_x(probe, fe{{std::to_integer<std::uint64_t>(peer_x[31]), 0, 0, 0}}, false);
+         peer_x[31] = std::byte(std::to_integer<int>(peer_x[31]) + 1))
+    {
+    }
+    assert(!secp256k1::ecdh_xonly(secret, peer_x, privs[0]));
+
+    std::cout << "ecdh x only: from_jacobian " << std::chrono::duration<double, std::micro>(t1 - t0).count() / batch << " us, affine_x "
+              << std::chrono::duration<double, std::micro>(t2 - t1).count() / batch << " us, batched "
+              << std::chrono::duration<double, std::micro>(t3 - t2).count() / batch << " us, batched constant time "
+              << std::chrono::duration<double, std::micro>(t4 - t3).count() / batch << " us per key\n";
+  }
+
+  // lazy points: add / compare in jacobian, one batch inversion at serialization vs from_jacobian after every step
+  {
+    static constexpr std::size_t count = 1024;
+
+    const auto G_fe_precomp = secp256k1::precompute(secp256k1::to_jacobian(secp256k1::G));
+
+    std::vector<secp256k1::jcbn_crv_p> a(count), b(count);
+    for (std::size_t i = 0; i != count; ++i)
+    {
+      a[i] = secp256k1::windowed_scalar_mul(G_fe_precomp, sc_from_ix(privKeyA * (int)(i + 3)));
+      b[i] = secp256k1::windowed_scalar_mul(G_fe_precomp, sc_from_ix(privKeyB * (int)(i + 3)));
+    }
+
+    // eager: normalize each input and each sum, then encode
+    std::vector<std::byte> eager(count * 33), lazy(count * 33);
+    const auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != count; ++i)
+    {
+      const secp256k1::crv_p pa = secp256k1::from_jacobian(a[i]);
+      const secp256k1::crv_p pb = secp256k1::from_jacobian(b[i]);
+      const secp256k1::crv_p s  = secp256k1::from_jacobian(secp256k1::point_add(secp256k1::to_jacobian(pa), secp256k1::to_jacobian(pb)));
+      secp256k1::to_compressed(s, &eager[i * 33]);
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+
+    std::vector<secp256k1::lazy_point> sums(count);
+    std::vector<std::uint8_t> ok(count);
+    for (std::size_t i = 0; i != count; ++i)
+    {
+      sums[i] = secp256k1::lazy_point{a[i]} + secp256k1::lazy_point{b[i]};
+    }
+    [[maybe_unused]] const bool all = secp256k1::serialize_all(sums, lazy, ok);
+    const auto t2                   = std::chrono::steady_clock::now();
+
+    assert(all && eager == lazy);
+    assert(std::all_of(sums.begin(), sums.end(), [](const secp256k1::lazy_point& p) { return p.is_normalized(); }));
+
+    // equality needs no normalization, doubling is adding to itself, O doesn't serialize
+    secp256k1::lazy_point p{a[0]}, q{b[0]};
+    assert(p + q == q + p && p + p == p.doubled() && p != q && !p.is_normalized());
+    assert(secp256k1::from_jacobian(a[0]) == p.affine() && p.is_normalized() && p == secp256k1::lazy_point{a[0]});
+
+    std::array<std::byte, 65> buf;
+    secp256k1::lazy_point o;
+    assert(o.is_identity() && o.is_normalized() && !o.serialize(buf) && o + p == p);
+    secp256k1::crv_p back;
+    assert(p.serialize(buf) && secp256k1::sec1_decode(back, buf) && back == p.affine());
+
+    std::cout << "lazy normalization: eager " << std::chrono::duration<double, std::micro>(t1 - t0).count() / count << " us/point, lazy "
+              << std::chrono::duration<double, std::micro>(t2 - t1).count() / count << " us/point\n";
+  }
+
+  // sha-ni vs portable compression, hkdf (RFC 5869 vectors) and ecdh straight into hkdf
+  {
+    const auto from_hex = [](std::string_view _h)
+    {
+      std::vector<std::byte> out(_h.size() / 2);
+      [[maybe_unused]] const bool ok = hex_decode(_h, out);
+      assert(ok);
+      return out;
+    };
+
+    // same state from both kernels over a few MB of random blocks
+    std::vector<std::byte> data(1 << 22);
+    os_random rng;
+    rng.fill(data);
+
+    std::uint32_t ref[8], ni[8];
+    std::copy_n(detail::sha256_iv, 8, ref);
+    std::copy_n(detail::sha256_iv, 8, ni);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    detail::sha256_compress_portable(ref, data.data(), data.size() / 64);
+    const auto t1 = std::chrono::steady_clock::now();
+    detail::sha256_compress(ni, data.data(), data.size() / 64);
+    const auto t2 = std::chrono::steady_clock::now();
+    assert(std::equal(ref, ref + 8, ni));
+
+    // rfc 5869 test cases 1 and 3
+    const auto ikm = from_hex("0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b");
+    const auto prk = hkdf_extract(from_hex("000102030405060708090a0b0c"), ikm);
+    assert(std::vector<std::byte>(prk.begin(), prk.end()) == from_hex("077709362c2e32df0ddc3f0dc47bba6390b6c73bb50f9c3122ec844ad7c2b3e5"));
+
+    std::vector<std::byte> okm(42);
+    hkdf_expand(prk, from_hex("f0f1f2f3f4f5f6f7f8f9"), okm);
+    assert(okm == from_hex("3cb25f25faacd57a90434f64d0362f2a2d2d0a90cf1a5a4c5db02d56ecc4c5bf34007208d5b887185865"));
+
+    hkdf_sha256(okm, ikm);
+    assert(okm == from_hex("8da4e775a563c18f715f802a063c5a31b8a11f5c5ee1879ec3454e5f3c738d2d9d201395faa4b61a96c8"));
+
+    // ecdh + kdf in one call matches doing it by hand, both sides get the same key
+    const sc a = sc_from_ix(privKeyA), b = sc_from_ix(privKeyB);
+    const auto A = secp256k1::precompute(secp256k1::fixed_base_mul(a));
+    const auto B = secp256k1::precompute(secp256k1::fixed_base_mul(b));
+
+    const auto salt = from_hex("73616c74"), info = from_hex("696e666f");
+    std::array<std::byte, 32> k_ab, k_ba, k_ref;
+    [[maybe_unused]] const bool ab = secp256k1::ecdh_hkdf(k_ab, B, a, salt, info);
+    [[maybe_unused]] const bool ba = secp256k1::ecdh_hkdf(k_ba, A, b, salt, info);
+
+    std::byte x[32];
+    fe_to_bytes(secp256k1::from_jacobian(secp256k1::windowed_scalar_mul(B, a)).x, x);
+    hkdf_sha256(k_ref, x, salt, info);
+    assert(ab && ba && k_ab == k_ba && k_ab == k_ref);
+
+    static constexpr std::size_t runs = 1 << 14;
+    const auto t3                     = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != runs; ++i)
+    {
+      hkdf_sha256(k_ref, k_ref, salt, info);
+    }
+    const auto t4 = std::chrono::steady_clock::now();
+
+    const auto gbps = [&](auto _d) { return data.size() / std::chrono::duration<double>(_d).count() / 1e9; };
+    std::cout << "sha256 (" << sha256_kernel.name << "): " << gbps(t2 - t1) << " GB/s, portable " << gbps(t1 - t0)
+              << " GB/s, hkdf 32 bytes: " << std::chrono::duration<double, std::nano>(t4 - t3).count() / runs << " ns\n";
+  }
+
+  // multi buffer sha256 against one message at a time, then the hashed batch ECDH secret
+  {
+    os_random rng;
+
+    // lengths around the padding edges, counts that leave a tail for the single buffer path
+    for (const std::size_t len : {0, 32, 55, 56, 64, 100, 200})
+    {
+      static constexpr std::size_t count = 37;
+
+      std::vector<std::byte> msgs(count * len);
+      rng.fill(msgs);
+
+      std::vector<sha256_digest> many(count);
+      sha256_many(msgs, len, many);
+      for (std::size_t i = 0; i != count; ++i)
+      {
+        assert(many[i] == sha256::hash(std::span{msgs}.subspan(i * len, len)));
+      }
+    }
+
+    static constexpr std::size_t secrets = 1 << 14;
+
+    std::vector<std::byte> xs(secrets * 32);
+    rng.fill(xs);
+    std::vector<sha256_digest> one(secrets), many(secrets);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != secrets; ++i)
+    {
+      one[i] = sha256::hash(std::span{xs}.subspan(i * 32, 32));
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    sha256_many(xs, 32, many);
+    const auto t2 = std::chrono::steady_clock::now();
+    assert(one == many);
+
+    // ecdh_sha256_many is sha256 over each ecdh_x_many output
+    static constexpr std::size_t batch = 32;
+
+    const auto G_fe_precomp = secp256k1::precompute(secp256k1::to_jacobian(secp256k1::G));
+
+    std::vector<ix> scalars;
+    std::vector<sc> privs;
+    std::vector<std::vector<secp256k1::jcbn_crv_p>> peers;
+    for (std::size_t i = 0; i != batch; ++i)
+    {
+      scalars.push_back((privKeyA * (int)(i + 3) + privKeyB) % mod_global);
+      privs.push_back(sc_from_ix(scalars.back()));
+      peers.push_back(secp256k1::precompute(secp256k1::windowed_scalar_mul(G_fe_precomp, privKeyB * (int)(i + 7) % mod_global)));
+    }
+
+    std::vector<const std::vector<secp256k1::jcbn_crv_p>*> peer_ptrs;
+    for (const auto& peer : peers)
+    {
+      peer_ptrs.push_back(&peer);
+    }
+
+    std::vector<fe> x(batch);
+    std::vector<sha256_digest> hashed(batch);
+    std::vector<sha256_digest> hashed_ct(batch);
+    std::vector<std::uint8_t> ok(batch), ok_hashed(batch), ok_hashed_ct(batch);
+    secp256k1::ecdh_x_many(peer_ptrs, scalars, x, ok);
+    secp256k1::ecdh_sha256_many(peer_ptrs, scalars, hashed, ok_hashed);
+    secp256k1::ecdh_sha256_many(peer_ptrs, privs, hashed_ct, ok_hashed_ct);
+
+    for (std::size_t i = 0; i != batch; ++i)
+    {
+      std::byte bytes[32];
+      fe_to_bytes(x[i], bytes);
+      assert(ok[i] && ok_hashed[i] && hashed[i] == sha256::hash(bytes));
+      assert(ok_hashed_ct[i] && hashed_ct[i] == hashed[i]);
+    }
+
+    const auto per = [&](auto _d) { return std::chrono::duration<double, std::nano>(_d).count() / secrets; };
+    std::cout << "sha256 of 32 byte secrets (" << sha256_mb_kernel.name << "): " << per(t2 - t1) << " ns, one at a time ("
+              << sha256_kernel.name << "): " << per(t1 - t0) << " ns\n";
+  }
+
+  // chacha20 / poly1305 / AEAD against RFC 8439 (2.4.2, 2.5.2, 2.8.2), then ECIES round trips
+  {
+    const auto from_hex = [](std::string_view _h)
+    {
+      std::vector<std::byte> out(_h.size() / 2);
+      [[maybe_unused]] const bool ok = hex_decode(_h, out);
+      assert(ok);
+      return out;
+    };
+
+    const std::string_view sunscreen =
+        "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+    const auto pt = std::as_bytes(std::span{sunscreen});
+
+    std::array<std::byte, 32> key;
+    for (std::size_t i = 0; i != 32; ++i)
+    {
+      key[i] = std::byte(i);
+    }
+    const auto nonce = from_hex("000000000000004a00000000");
+
+    // fed in uneven chunks so the buffered partial blocks get exercised
+    std::vector<std::byte> ct(pt.size());
+    {
+      chacha20 c{key, std::span<const std::byte, 12>{nonce}, 1};
+      static constexpr std::size_t steps[] = {1, 7, 64, 13};
+      for (std::size_t off = 0, i = 0; off != pt.size(); ++i)
+      {
+        const std::size_t n = std::min(steps[i % 4], pt.size() - off);
+        c.apply(pt.subspan(off, n), std::span{ct}.subspan(off, n));
+        off += n;
+      }
+    }
+    assert(ct == from_hex("6e2e359a2568f98041ba0728dd0d6981e97e7aec1d4360c20a27afccfd9fae0bf91b65c5524733ab8f593dabcd62b3571639d624e651"
+                          "52ab8f530c359f0861d807ca0dbf500d6a6156a38e088a22b65e52bc514d16ccf806818ce91ab77937365af90bbf74a35be6b40b8e"
+                          "edf2785e42874d"));
+
+    const auto poly_key = from_hex("85d6be7857556d337f4452fe42d506a80103808afb0db2fd4abff6af4149f51b");
+    const auto msg      = std::as_bytes(std::span{std::string_view{"Cryptographic Forum Research Group"}});
+    poly1305 mac{std::span<const std::byte, 32>{poly_key}};
+    mac.update(msg.first(5)).update(msg.subspan(5, 20)).update(msg.subspan(25));
+    assert(std::ranges::equal(mac.finalize(), from_hex("a8061dc1305136c6c22b8baf0c0127a9")));
+
+    std::array<std::byte, 32> aead_key;
+    for (std::size_t i = 0; i != 32; ++i)
+    {
+      aead_key[i] = std::byte(0x80 + i);
+    }
+    const auto aead_nonce = from_hex("070000004041424344454647");
+    const auto aad        = from_hex("50515253c0c1c2c3c4c5c6c7");
+
+    std::vector<std::byte> sealed(pt.size() + poly1305_tag_size), opened(pt.size());
+    chacha20_poly1305::seal(aead_key, std::span<const std::byte, 12>{aead_nonce}, aad, pt, sealed);
+    assert(std::ranges::equal(std::span{sealed}.first(16), from_hex("d31a8d34648e60db7b86afbc53ef7ec2")));
+    assert(std::ranges::equal(std::span{sealed}.last(16), from_hex("1ae10b594f09e26a7e902ecbd0600691")));
+    assert(chacha20_poly1305::open(aead_key, std::span<const std::byte, 12>{aead_nonce}, aad, sealed, opened));
+    assert(std::ranges::equal(opened, pt));
+    sealed[3] ^= std::byte{1};
+    assert(!chacha20_poly1305::open(aead_key, std::span<const std::byte, 12>{aead_nonce}, aad, sealed, opened));
+
+    // the lane kernels against one block at a time over a long key stream
+    std::vector<std::byte> ks(1 << 20), ks_ref(ks.size());
+    chacha20{key, std::span<const std::byte, 12>{nonce}}.keystream(ks);
+    {
+      std::uint32_t state[16] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+      for (std::size_t i = 0; i != 8; ++i)
+      {
+        state[4 + i] = detail::load_le32(key.data() + 4 * i);
+      }
+      for (std::size_t i = 0; i != 3; ++i)
+      {
+        state[13 + i] = detail::load_le32(nonce.data() + 4 * i);
+      }
+      for (std::size_t b = 0; b != ks_ref.size() / 64; ++b, ++state[12])
+      {
+        detail::chacha20_block(state, &ks_ref[64 * b]);
+      }
+    }
+    assert(ks == ks_ref);
+
+    os_random rng;
+
+    // ephemeral scalars in GmpWrapper form are wiped before they are freed
+    ix secret = sc_to_ix(secp256k1::detail::sc_from_limbs(secp256k1::random_scalar(rng)));
+    secret.wipe();
+    assert(secret == 0);
+
+    static constexpr std::size_t recipients = 64;
+    std::vector<sc> privs;
+    std::vector<secp256k1::crv_p> pubs;
+    for (std::size_t i = 0; i != recipients; ++i)
+    {
+      privs.push_back(secp256k1::detail::sc_from_limbs(secp256k1::random_scalar(rng)));
+      pubs.push_back(secp256k1::from_jacobian(secp256k1::fixed_base_mul(privs.back())));
+    }
+
+    // one shot, and a streamed 1 MB payload decrypted in one go
+    std::vector<std::byte> big(1 << 20);
+    rng.fill(big);
+    std::vector<std::byte> big_ct(big.size() + secp256k1::ecies_overhead), big_pt(big.size());
+
+    const auto t0 = std::chrono::steady_clock::now();
+    {
+      secp256k1::ecies_encryptor enc{rng, pubs[0], aad};
+      assert(enc.valid());
+      std::ranges::copy(enc.header(), big_ct.begin());
+      for (std::size_t off = 0; off < big.size(); off += 4097)
+      {
+        const std::size_t n = std::min<std::size_t>(4097, big.size() - off);
+        enc.update(std::span{big}.subspan(off, n), std::span{big_ct}.subspan(secp256k1::ecies_header_size + off, n));
+      }
+      std::ranges::copy(enc.finalize(), big_ct.end() - poly1305_tag_size);
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    assert(secp256k1::ecies_decrypt(privs[0], big_ct, big_pt, aad) && big_pt == big);
+    assert(!secp256k1::ecies_decrypt(privs[1], big_ct, big_pt, aad));
+    assert(!secp256k1::ecies_decrypt(privs[0], big_ct, big_pt));
+
+    // batch: a short message to every recipient, each decrypts its own
+    static constexpr std::size_t msg_size = 64;
+    std::vector<std::byte> msgs(recipients * msg_size), cts(recipients * (msg_size + secp256k1::ecies_overhead)),
+        pts(msgs.size());
+    rng.fill(msgs);
+
+    std::vector<std::span<const std::byte>> msg_spans, ct_spans;
+    std::vector<std::span<std::byte>> ct_outs, pt_outs;
+    for (std::size_t i = 0; i != recipients; ++i)
+    {
+      msg_spans.push_back(std::span{msgs}.subspan(i * msg_size, msg_size));
+      ct_outs.push_back(std::span{cts}.subspan(i * (msg_size + secp256k1::ecies_overhead), msg_size + secp256k1::ecies_overhead));
+      ct_spans.push_back(ct_outs.back());
+      pt_outs.push_back(std::span{pts}.subspan(i * msg_size, msg_size));
+    }
+
+    std::vector<std::uint8_t> ok(recipients);
+    const auto t2 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != recipients; ++i)
+    {
+      secp256k1::ecies_encrypt(rng, pubs[i], msg_spans[i], ct_outs[i]);
+    }
+    const auto t3 = std::chrono::steady_clock::now();
+    [[maybe_unused]] const bool all = secp256k1::ecies_encrypt_many(rng, pubs, msg_spans, ct_outs, ok);
+    const auto t4 = std::chrono::steady_clock::now();
+    assert(all);
+
+    for (std::size_t i = 0; i != recipients; ++i)
+    {
+      assert(secp256k1::ecies_decrypt(privs[i], ct_spans[i], pt_outs[i]) && std::ranges::equal(pt_outs[i], msg_spans[i]));
+    }
+
+    // many messages to one recipient, one of them tampered with
+    const std::vector<secp256k1::crv_p> same(recipients, pubs[0]);
+    secp256k1::ecies_encrypt_many(rng, same, msg_spans, ct_outs, ok);
+    cts[5 * (msg_size + secp256k1::ecies_overhead) + 40] ^= std::byte{1};
+
+    const auto t5 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != recipients; ++i)
+    {
+      secp256k1::ecies_decrypt(privs[0], ct_spans[i], pt_outs[i]);
+    }
+    const auto t6 = std::chrono::steady_clock::now();
+    [[maybe_unused]] const bool all_open = secp256k1::ecies_decrypt_many(privs[0], ct_spans, pt_outs, ok);
+    const auto t7 = std::chrono::steady_clock::now();
+
+    assert(!all_open && !ok[5]);
+    for (std::size_t i = 0; i != recipients; ++i)
+    {
+      assert(i == 5 || (ok[i] && std::ranges::equal(pt_outs[i], msg_spans[i])));
+    }
+
+    const auto us = [](auto _d) { return std::chrono::duration<double, std::micro>(_d).count() / recipients; };
+    std::cout << "ecies (chacha20 " << chacha20_kernel.name << "): 1 MB stream "
+              << big.size() / std::chrono::duration<double>(t1 - t0).count() / 1e9 << " GB/s, 64 byte messages encrypt "
+              << us(t4 - t3) << " us batched vs " << us(t3 - t2) << " us, decrypt " << us(t7 - t6) << " us batched vs " << us(t6 - t5)
+              << " us\n";
+  }
+
+  // chacha20 drbg: fork safety, rejection sampled scalars, throughput against getrandom
+  {
+    chacha_drbg& drbg = chacha_drbg::local();
+
+    std::array<std::byte, 32> a, b;
+    drbg.fill(a);
+    drbg.fill(b);
+    assert(a != b);
+
+    // the child must not repeat the parent's stream, nor the parent's buffered getrandom bytes
+    const auto forked_apart = [](auto& _rng)
+    {
+      std::array<std::byte, 32> mine, theirs;
+      int fds[2];
+      [[maybe_unused]] const int piped = pipe(fds);
+      assert(piped == 0);
+      if (const pid_t pid = fork(); pid == 0)
+      {
+        _rng.fill(mine);
+        [[maybe_unused]] const ssize_t w = write(fds[1], mine.data(), mine.size());
+        _exit(0);
+      }
+      else
+      {
+        _rng.fill(mine);
+        [[maybe_unused]] const ssize_t r = read(fds[0], theirs.data(), theirs.size());
+        waitpid(pid, nullptr, 0);
+        close(fds[0]);
+        close(fds[1]);
+        return r == 32 && mine != theirs;
+      }
+    };
+    assert(forked_apart(drbg));
+    os_random buffered;
+    buffered.fill(a);
+    assert(forked_apart(buffered));
+
+    static constexpr std::size_t draws = 1 << 14;
+
+    std::vector<std::array<std::uint64_t, 4>> k(draws);
+    os_random os;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (auto& x : k)
+    {
+      x = secp256k1::random_scalar(os);
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    for (auto& x : k)
+    {
+      x = secp256k1::random_scalar(drbg);
+    }
+    const auto t2 = std::chrono::steady_clock::now();
+
+    for (const auto& x : k)
+    {
+      const sc s = secp256k1::detail::sc_from_limbs(x);
+      assert(!sc_is_zero(s) && sc_to_ix(s) < mod_global);
+    }
+
+    // GmpWrapper draws stay below the bound and hit all of it
+    std::array<int, 10> seen{};
+    for (int i = 0; i != 1000; ++i)
+    {
+      const ix r = ix::random_below(10, drbg);
+      assert(r >= 0 && r < 10);
+
+      std::uint64_t v;
+      r.to_limbs(&v, 1);
+      ++seen[v];
+    }
+    assert(std::ranges::find(seen, 0) == seen.end());
+    assert(ix::random_below(mod_global, drbg) < mod_global);
+
+    // bigint_rand_func shaped entry point
+    std::uint8_t raw[48] = {};
+    drbg_rand_bytes(raw, sizeof(raw));
+    assert(std::any_of(raw, raw + sizeof(raw), [](std::uint8_t _c) { return _c != 0; }));
+
+    std::vector<std::byte> bulk(1 << 24);
+    const auto t3 = std::chrono::steady_clock::now();
+    os.fill(bulk);
+    const auto t4 = std::chrono::steady_clock::now();
+    drbg.fill(bulk);
+    const auto t5 = std::chrono::steady_clock::now();
+
+    const auto ns   = [](auto _d) { return std::chrono::duration<double, std::nano>(_d).count() / draws; };
+    const auto gbps = [&](auto _d) { return bulk.size() / std::chrono::duration<double>(_d).count() / 1e9; };
+    std::cout << "chacha_drbg (" << chacha20_kernel.name << "): scalar " << ns(t2 - t1) << " ns vs getrandom " << ns(t1 - t0)
+              << " ns, bulk " << gbps(t5 - t4) << " GB/s vs " << gbps(t4 - t3) << " GB/s\n";
+  }
+
+  // single ECDH latency, independent multiplies packed into the lanes of one vector (packed_latency_bench.h,
+  // benchmark only, the packed formulas lose to the scalar kernel)
+  {
+    static constexpr std::size_t runs = 200;
+
+    const auto G_fe_precomp = secp256k1::precompute(secp256k1::to_jacobian(secp256k1::G));
+    const auto peer         = secp256k1::precompute(secp256k1::windowed_scalar_mul(G_fe_precomp, privKeyB));
+
+    const auto percentiles = [&](std::string_view _name, auto&& _fn)
+    {
+      std::vector<long> ns;
+      for (std::size_t i = 0; i != runs; ++i)
+      {
+        const ix k     = (privKeyA * (int)(i + 1)) % mod_global;
+        const auto beg = std::chrono::steady_clock::now();
+        const auto res = _fn(k);
+        ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - beg).count());
+        assert(secp256k1::from_jacobian(res) == secp256k1::from_jacobian(secp256k1::windowed_scalar_mul(peer, k)));
+      }
+      std::sort(ns.begin(), ns.end());
+      std::cout << _name << ": p50 " << ns[runs / 2] / 1000 << " us, p99 " << ns[runs * 99 / 100] / 1000 << " us\n";
+    };
+
+    percentiles("ECDH latency scalar", [&](const ix& k) { return secp256k1::windowed_scalar_mul(peer, k); });
+    percentiles("ECDH latency constant time", [&](const ix& k) { return secp256k1::windowed_scalar_mul_ct(peer, sc_from_ix(k)); });
+    if (lanes_avx2::supported())
+    {
+      percentiles("ECDH latency packed avx2", [&](const ix& k) { return secp256k1::windowed_scalar_mul_latency<lanes_avx2>(peer, k); });
+    }
+    if (lanes_ifma::supported())
+    {
+      percentiles("ECDH latency packed ifma", [&](const ix& k) { return secp256k1::windowed_scalar_mul_latency<lanes_ifma>(peer, k); });
+    }
+  }
+
   return 0;
 }
 
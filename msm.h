@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "curve.h"
+#include "scalar.h"
+
+/*
+  multi scalar multiplication sum k_i P_i (pippenger / bucket method).
+
+  per c bit window every point is dropped into the bucket of its digit (one mixed add), then
+  the buckets are summed as sum d * B_d with two running sums. that is about 256 / c adds per
+  point plus 2^(c+1) per window instead of a full scalar mul per point, and c grows with the
+  number of points. the windows share one doubling chain.
+*/
+
+namespace blue_crypto::secp256k1
+{
+
+/* bucket window for _n points, roughly log2(n) - 2 */
+[[gnu::const]] inline std::size_t
+msm_window(std::size_t _n) noexcept
+{
+  return std::clamp<std::size_t>(std::bit_width(_n), 4, 15) - 2;
+}
+
+inline jcbn_crv_p
+msm(std::span<const crv_p> _points, std::span<const sc> _scalars)
+{
+  assert(_points.size() == _scalars.size());
+
+  const std::size_t c       = msm_window(_points.size());
+  const std::size_t windows = (256 + c - 1) / c;
+
+  std::vector<jcbn_crv_p> buckets((std::size_t{1} << c) - 1);
+  jcbn_crv_p acc{j_identity_element};
+
+  for (std::size_t w = windows; w-- != 0;)
+  {
+    for (std::size_t j = 0; j != c && !is_identity(acc); ++j)
+    {
+      acc = point_double(acc);
+    }
+
+    std::fill(buckets.begin(), buckets.end(), j_identity_element);
+    for (std::size_t i = 0; i != _points.size(); ++i)
+    {
+      if (const std::size_t d = sc_bits(_scalars[i], w * c, c); d != 0)
+      {
+        buckets[d - 1] = point_add_mixed(buckets[d - 1], _points[i]);
+      }
+    }
+
+    // sum d * B_d = B_top + (B_top + B_top-1) + ...
+    jcbn_crv_p running{j_identity_element}, sum{j_identity_element};
+    for (std::size_t d = buckets.size(); d-- != 0;)
+    {
+      running = point_add(running, buckets[d]);
+      sum     = point_add(sum, running);
+    }
+    acc = point_add(acc, sum);
+  }
+
+  return acc;
+}
+
+} // namespace blue_crypto::secp256k1
@@ -0,0 +1,328 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "curve_simd.h"
+
+/*
+  benchmark only, not part of the library: the latency mode experiment for a single ECDH. it
+  measured slower than the scalar kernel on every backend (the permutes between the multiply
+  rounds eat what the packing saves), so nothing dispatches to it. main.cpp is the only user,
+  it times it next to windowed_scalar_mul.
+*/
+
+namespace blue_crypto::secp256k1
+{
+
+/* lane l of _out <- lane _lane[l] of *_src[l] for l < _n, other lanes are left alone */
+[[gnu::target("avx2")]] inline void
+packed_gather(fe_x4& _out, const fe_x4* const* _src, const std::size_t* _lane, std::size_t _n) noexcept
+{
+  __m256i acc[10];
+  for (int i = 0; i != 10; ++i)
+  {
+    acc[i] = _mm256_load_si256((const __m256i*)_out.v[i]);
+  }
+
+  std::uint32_t done = 0;
+  for (std::size_t l = 0; l != _n; ++l)
+  {
+    if (done >> l & 1)
+    {
+      continue;
+    }
+
+    // every lane that reads from the same source goes in one permute + blend
+    alignas(32) std::int32_t idx[8]{};
+    alignas(32) std::int64_t sel[4]{};
+    for (std::size_t k = l; k != _n; ++k)
+    {
+      if (_src[k] == _src[l])
+      {
+        idx[2 * k]     = (std::int32_t)(2 * _lane[k]);
+        idx[2 * k + 1] = (std::int32_t)(2 * _lane[k] + 1);
+        sel[k]         = -1;
+        done |= 1u << k;
+      }
+    }
+
+    const __m256i vidx = _mm256_load_si256((const __m256i*)idx);
+    const __m256i vsel = _mm256_load_si256((const __m256i*)sel);
+    for (int i = 0; i != 10; ++i)
+    {
+      const __m256i v = _mm256_permutevar8x32_epi32(_mm256_load_si256((const __m256i*)_src[l]->v[i]), vidx);
+      acc[i]          = _mm256_blendv_epi8(acc[i], v, vsel);
+    }
+  }
+
+  for (int i = 0; i != 10; ++i)
+  {
+    _mm256_store_si256((__m256i*)_out.v[i], acc[i]);
+  }
+}
+
+/* lane l of _out <- lane _lane[l] of *_src[l] for l < _n, other lanes are left alone */
+[[gnu::target("avx512f,avx512ifma")]] inline void
+packed_gather(fe_x8& _out, const fe_x8* const* _src, const std::size_t* _lane, std::size_t _n) noexcept
+{
+  __m512i acc[5];
+  for (int i = 0; i != 5; ++i)
+  {
+    acc[i] = _mm512_load_si512((const __m512i*)_out.v[i]);
+  }
+
+  std::uint32_t done = 0;
+  for (std::size_t l = 0; l != _n; ++l)
+  {
+    if (done >> l & 1)
+    {
+      continue;
+    }
+
+    alignas(64) std::int64_t idx[8]{};
+    __mmask8 sel = 0;
+    for (std::size_t k = l; k != _n; ++k)
+    {
+      if (_src[k] == _src[l])
+      {
+        idx[k] = (std::int64_t)_lane[k];
+        sel |= (__mmask8)(1u << k);
+        done |= 1u << k;
+      }
+    }
+
+    const __m512i vidx = _mm512_load_si512((const __m512i*)idx);
+    for (int i = 0; i != 5; ++i)
+    {
+      acc[i] = _mm512_mask_permutexvar_epi64(acc[i], sel, vidx, _mm512_load_si512((const __m512i*)_src[l]->v[i]));
+    }
+  }
+
+  for (int i = 0; i != 5; ++i)
+  {
+    _mm512_store_si512((__m512i*)_out.v[i], acc[i]);
+  }
+}
+
+/*
+  latency mode: one point per vector, lanes [X, Y, Z, -]. the
+  independent multiplies inside a single point_add / point_double get packed into the lanes of
+  one B::mul so a single ECDH needs 5 (add) and 4 (double) dependent multiply rounds instead of
+  16 and 8. unused lanes just carry whatever, they are never read back.
+*/
+template <class B>
+struct jcbn_crv_packed
+{
+  typename B::elem v{};
+};
+
+/* lane l of _dst <- lane _src[l].second of *_src[l].first, done with permutes (packed_gather) */
+template <class B, std::size_t N>
+inline void
+gather_lanes(typename B::elem& _dst, const std::pair<const typename B::elem*, std::size_t> (&_src)[N]) noexcept
+{
+  static_assert(N <= B::width);
+
+  const typename B::elem* src[N];
+  std::size_t lane[N];
+  for (std::size_t l = 0; l != N; ++l)
+  {
+    src[l]  = _src[l].first;
+    lane[l] = _src[l].second;
+  }
+  packed_gather(_dst, src, lane, N);
+}
+
+template <class B>
+inline jcbn_crv_packed<B>
+to_packed(const jcbn_crv_p& _p) noexcept
+{
+  jcbn_crv_packed<B> out;
+  B::put(out.v, 0, _p.x);
+  B::put(out.v, 1, _p.y);
+  B::put(out.v, 2, _p.z);
+  return out;
+}
+
+template <class B>
+inline jcbn_crv_p
+from_packed(const jcbn_crv_packed<B>& _p) noexcept
+{
+  return {B::get(_p.v, 0), B::get(_p.v, 1), B::get(_p.v, 2)};
+}
+
+/* dbl-2009-l in 4 multiply rounds, no y == 0 / identity check */
+template <class B>
+inline void
+point_double(jcbn_crv_packed<B>& _out, const jcbn_crv_packed<B>& _p1) noexcept
+{
+  using elem    = typename B::elem;
+  const elem& p = _p1.v;
+  const elem zero{};
+  elem a{}, b{}, m1, m2, m3, m4;
+
+  // [A, B, YZ] = [X, Y, Y] * [X, Y, Z]
+  gather_lanes<B>(a, {{&p, 0}, {&p, 1}, {&p, 1}});
+  B::mul(m1, a, p);
+
+  // [C, (X + B)^2] = [B, X + B]^2
+  gather_lanes<B>(a, {{&m1, 1}, {&p, 0}});
+  gather_lanes<B>(b, {{&zero, 0}, {&m1, 1}});
+  B::add(a, a, b);
+  B::sqr(m2, a);
+
+  // [D, E] = 2 [(X + B)^2 - A - C, A] + [0, A]
+  gather_lanes<B>(a, {{&m2, 1}, {&m1, 0}});
+  gather_lanes<B>(b, {{&m1, 0}, {&zero, 0}});
+  B::sub(a, a, b);
+  gather_lanes<B>(b, {{&m2, 0}});
+  B::sub(a, a, b);
+  B::add(a, a, a);
+  gather_lanes<B>(b, {{&zero, 0}, {&m1, 0}});
+  B::add(a, a, b);
+  const elem de = a;
+
+  // F = E^2, X3 = F - 2D
+  gather_lanes<B>(a, {{&de, 1}});
+  B::sqr(m3, a);
+  B::sub(a, m3, de);
+  B::sub(a, a, de);
+  const elem x3 = a;
+
+  // Y3 = E (D - X3) - 8C
+  B::sub(b, de, x3);
+  gather_lanes<B>(a, {{&de, 1}});
+  B::mul(m4, a, b);
+  gather_lanes<B>(a, {{&m2, 0}});
+  B::add(a, a, a);
+  B::add(a, a, a);
+  B::add(a, a, a);
+  B::sub(m4, m4, a);
+
+  // Z3 = 2YZ
+  gather_lanes<B>(b, {{&m1, 2}});
+  B::add(b, b, b);
+
+  gather_lanes<B>(_out.v, {{&x3, 0}, {&m4, 0}, {&b, 0}});
+}
+
+/* generic jacobian add in 5 multiply rounds, same restrictions as the lane version */
+template <class B>
+inline void
+point_add(jcbn_crv_packed<B>& _out, const jcbn_crv_packed<B>& _p1, const jcbn_crv_packed<B>& _p2) noexcept
+{
+  using elem    = typename B::elem;
+  const elem& p = _p1.v;
+  const elem& q = _p2.v;
+  elem a{}, b{}, m1, m2, m3, m4, m5, t{}, u{};
+
+  // [Z1Z1, Z2Z2, Y1Z2, Y2Z1]
+  gather_lanes<B>(a, {{&p, 2}, {&q, 2}, {&p, 1}, {&q, 1}});
+  gather_lanes<B>(b, {{&p, 2}, {&q, 2}, {&q, 2}, {&p, 2}});
+  B::mul(m1, a, b);
+
+  // [U1, U2, S1, S2]
+  gather_lanes<B>(a, {{&p, 0}, {&q, 0}, {&m1, 2}, {&m1, 3}});
+  gather_lanes<B>(b, {{&m1, 1}, {&m1, 0}, {&m1, 1}, {&m1, 0}});
+  B::mul(m2, a, b);
+
+  // [H, -H, R, -R]
+  gather_lanes<B>(t, {{&m2, 1}, {&m2, 0}, {&m2, 3}, {&m2, 2}});
+  B::sub(t, t, m2);
+  const elem& hr = t;
+
+  // [HH, Z1Z2, RR]
+  gather_lanes<B>(a, {{&hr, 0}, {&p, 2}, {&hr, 2}});
+  gather_lanes<B>(b, {{&hr, 0}, {&q, 2}, {&hr, 2}});
+  B::mul(m3, a, b);
+
+  // [HHH, V, Z3]
+  gather_lanes<B>(a, {{&hr, 0}, {&m2, 0}, {&m3, 1}});
+  gather_lanes<B>(b, {{&m3, 0}, {&m3, 0}, {&hr, 0}});
+  B::mul(m4, a, b);
+
+  // X3 = RR - HHH - 2V in lane 0, V in lane 1
+  gather_lanes<B>(a, {{&m3, 2}, {&m4, 1}});
+  gather_lanes<B>(b, {{&m4, 0}});
+  B::sub(a, a, b);
+  gather_lanes<B>(b, {{&m4, 1}});
+  B::sub(a, a, b);
+  B::sub(a, a, b);
+  const elem& x3 = a;
+
+  // [R (V - X3), S1 HHH]
+  gather_lanes<B>(b, {{&m4, 1}, {&m4, 0}});
+  gather_lanes<B>(u, {{&x3, 0}});
+  B::sub(b, b, u);
+  gather_lanes<B>(u, {{&hr, 2}, {&m2, 2}});
+  B::mul(m5, u, b);
+
+  gather_lanes<B>(u, {{&m5, 1}});
+  B::sub(u, m5, u);
+
+  gather_lanes<B>(_out.v, {{&x3, 0}, {&u, 0}, {&m4, 2}});
+}
+
+/* single scalar mul with the packed formulas, benchmark only (see jcbn_crv_packed) */
+template <class B>
+jcbn_crv_p
+windowed_scalar_mul_latency(const std::vector<jcbn_crv_p>& _precomp, const GmpWrapper& _num)
+{
+  std::array<jcbn_crv_packed<B>, std::size_t{1} << window_size> table;
+  for (std::size_t e = 1; e != table.size(); ++e)
+  {
+    table[e] = to_packed<B>(_precomp[e]);
+  }
+
+  jcbn_crv_packed<B> Q;
+  bool live           = false;
+  const std::size_t m = (_num.bitlength() + window_size - 1) / window_size;
+
+  for (std::size_t i = 0; i != m; ++i)
+  {
+    if (live)
+    {
+      for (std::size_t j = 0; j != window_size; ++j)
+      {
+        point_double(Q, Q);
+      }
+    }
+
+    const std::size_t nbits = _num.get_bits((m - i - 1) * window_size, window_size);
+
+    if (nbits == 0) [[unlikely]]
+    {
+      continue;
+    }
+
+    if (live)
+    {
+      point_add(Q, Q, table[nbits]);
+    }
+    else
+    {
+      Q    = table[nbits];
+      live = true;
+    }
+  }
+
+  if (!live)
+  {
+    return j_identity_element;
+  }
+
+  jcbn_crv_p out = from_packed(Q);
+  if (is_identity(out)) [[unlikely]]
+  {
+    out = windowed_scalar_mul(_precomp, _num);
+  }
+  return out;
+}
+
+} // namespace blue_crypto::secp256k1
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <system_error>
+
+#include <pthread.h>
+#include <sys/random.h>
+
+/*
+  randomness for key material.
+
+  os_random pulls from the kernel (getrandom) in 4 KiB blocks so drawing a scalar is a memcpy
+  instead of a syscall. keep one per thread, it is not synchronized. a pthread_atfork child
+  handler bumps fork_generation, and anything that buffers random bytes (os_random here,
+  chacha_drbg in drbg.h) drops its buffer when it sees a new generation, so a parent and
+  child never hand out the same bytes.
+*/
+
+namespace blue_crypto
+{
+
+namespace detail
+{
+
+inline std::atomic<std::uint64_t> fork_generation{0};
+
+inline const bool fork_handler_registered = []
+{
+  pthread_atfork(nullptr, nullptr, [] { fork_generation.fetch_add(1, std::memory_order_relaxed); });
+  return true;
+}();
+
+} // namespace detail
+
+/* zero memory in a way the compiler can't drop as a dead store */
+inline void
+secure_wipe(void* _p, std::size_t _n) noexcept
+{
+  volatile unsigned char* p = static_cast<volatile unsigned char*>(_p);
+  while (_n--)
+  {
+    *p++ = 0;
+  }
+}
+
+/* exactly _out.size() bytes from getrandom, short reads and EINTR are retried */
+inline void
+kernel_random(std::span<std::byte> _out)
+{
+  std::size_t got = 0;
+  while (got != _out.size())
+  {
+    const ssize_t r = getrandom(_out.data() + got, _out.size() - got, 0);
+    if (r < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      throw std::system_error(errno, std::generic_category(), "getrandom");
+    }
+    got += static_cast<std::size_t>(r);
+  }
+}
+
+class os_random
+{
+public:
+  os_random() = default;
+
+  os_random(const os_random&)            = delete;
+  os_random& operator=(const os_random&) = delete;
+
+  ~os_random() { secure_wipe(buf_.data(), buf_.size()); }
+
+  void
+  fill(std::span<std::byte> _out)
+  {
+    // forked since the last refill, the buffer is the parent's too
+    if (const std::uint64_t gen = detail::fork_generation.load(std::memory_order_relaxed); gen != generation_) [[unlikely]]
+    {
+      secure_wipe(buf_.data(), buf_.size());
+      pos_        = buf_.size();
+      generation_ = gen;
+    }
+
+    while (!_out.empty())
+    {
+      if (pos_ == buf_.size())
+      {
+        refill();
+      }
+
+      const std::size_t n = std::min(_out.size(), buf_.size() - pos_);
+      std::memcpy(_out.data(), buf_.data() + pos_, n);
+      // handed out bytes are not kept around
+      secure_wipe(buf_.data() + pos_, n);
+
+      pos_ += n;
+      _out = _out.subspan(n);
+    }
+  }
+
+  std::uint64_t
+  next_u64()
+  {
+    std::uint64_t out;
+    fill(std::as_writable_bytes(std::span{&out, 1}));
+    return out;
+  }
+
+private:
+  void
+  refill()
+  {
+    kernel_random(buf_);
+    pos_ = 0;
+  }
+
+  std::array<std::byte, 4096> buf_{};
+  std::size_t pos_          = buf_.size();
+  std::uint64_t generation_ = detail::fork_generation.load(std::memory_order_relaxed);
+};
+
+} // namespace blue_crypto
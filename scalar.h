@@ -0,0 +1,382 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "crypto.h"
+#include "field.h"
+
+/*
+  fixed width arithmetic mod the secp256k1 group order
+  n = 0xFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141
+
+  same layout as fe (4 little endian limbs, always fully reduced) and the same 256x256 -> 512
+  multiply kernels. n isn't as sparse as p but 2^256 - n is only 129 bits, so the 512 -> 256
+  reduction folds the top half back in with that constant a few times, then one conditional
+  subtract. nothing in here branches on the value, so it is fine for secret scalars.
+*/
+
+namespace blue_crypto
+{
+
+struct sc
+{
+  std::uint64_t n[4];
+
+  bool
+  operator==(const sc& other) const
+  {
+    return (n[0] == other.n[0]) && (n[1] == other.n[1]) && (n[2] == other.n[2]) && (n[3] == other.n[3]);
+  }
+
+  bool
+  operator!=(const sc& other) const
+  {
+    return !(this->operator==(other));
+  }
+};
+
+static constexpr sc sc_n    = {{0xBFD25E8CD0364141ull, 0xBAAEDCE6AF48A03Bull, 0xFFFFFFFFFFFFFFFEull, 0xFFFFFFFFFFFFFFFFull}};
+static constexpr sc sc_zero = {{0, 0, 0, 0}};
+static constexpr sc sc_one  = {{1, 0, 0, 0}};
+
+namespace detail
+{
+
+/* 2^256 - n */
+static constexpr std::uint64_t sc_c[3] = {0x402DA1732FC9BEBFull, 0x4551231950B75FC4ull, 1};
+
+/* _r (8 limbs) = _r[0..3] + _hi * (2^256 - n), _hi is _hn limbs and may alias _r[4..] */
+inline void
+sc_fold(std::uint64_t* _r, const std::uint64_t* _hi, std::size_t _hn) noexcept
+{
+  std::uint64_t hi[4];
+  for (std::size_t i = 0; i != _hn; ++i)
+  {
+    hi[i] = _hi[i];
+  }
+  for (std::size_t i = 4; i != 8; ++i)
+  {
+    _r[i] = 0;
+  }
+
+  for (std::size_t i = 0; i != _hn; ++i)
+  {
+    u128 carry = 0;
+    for (std::size_t j = 0; j != 3; ++j)
+    {
+      carry += (u128)hi[i] * sc_c[j] + _r[i + j];
+      _r[i + j] = (std::uint64_t)carry;
+      carry >>= 64;
+    }
+    for (std::size_t k = i + 3; k != 8; ++k)
+    {
+      carry += _r[k];
+      _r[k] = (std::uint64_t)carry;
+      carry >>= 64;
+    }
+  }
+}
+
+/* out = r - n if r >= n else r, r < 2^256, no branches */
+inline void
+sc_cond_sub_n(std::uint64_t* out, const std::uint64_t* r, std::uint64_t top) noexcept
+{
+  std::uint64_t s[4];
+  std::uint64_t borrow = 0;
+
+  for (int i = 0; i != 4; ++i)
+  {
+    const u128 d = (u128)r[i] - sc_n.n[i] - borrow;
+    s[i]         = (std::uint64_t)d;
+    borrow       = (std::uint64_t)(d >> 64) & 1;
+  }
+
+  // keep s if there was no borrow or the value had a bit above 2^256
+  const std::uint64_t mask = 0 - ((borrow ^ 1) | top);
+  for (int i = 0; i != 4; ++i)
+  {
+    out[i] = (s[i] & mask) | (r[i] & ~mask);
+  }
+}
+
+/* t is 8 limbs, 2^512 > t */
+inline void
+sc_reduce_512(std::uint64_t* out, const std::uint64_t* t) noexcept
+{
+  std::uint64_t r[8];
+  for (int i = 0; i != 4; ++i)
+  {
+    r[i] = t[i];
+  }
+
+  sc_fold(r, t + 4, 4); // < 2^386
+  sc_fold(r, r + 4, 3); // < 2^260
+  sc_fold(r, r + 4, 1); // < 2^256 + 2^133
+
+  sc_cond_sub_n(out, r, r[4]);
+}
+
+} // namespace detail
+
+inline void
+sc_mul(sc& out, const sc& a, const sc& b) noexcept
+{
+  std::uint64_t t[8];
+#if defined(__x86_64__)
+  if (fe_kernel.adx) [[likely]]
+  {
+    detail::mul_512_adx(t, a.n, b.n);
+  }
+  else
+#endif
+  {
+    detail::mul_512_portable(t, a.n, b.n);
+  }
+  detail::sc_reduce_512(out.n, t);
+}
+
+inline void
+sc_sqr(sc& out, const sc& a) noexcept
+{
+  std::uint64_t t[8];
+#if defined(__x86_64__)
+  if (fe_kernel.adx) [[likely]]
+  {
+    detail::sqr_512_adx(t, a.n);
+  }
+  else
+#endif
+  {
+    detail::sqr_512_portable(t, a.n);
+  }
+  detail::sc_reduce_512(out.n, t);
+}
+
+[[gnu::pure]] inline sc
+sc_mul(const sc& a, const sc& b) noexcept
+{
+  sc out;
+  sc_mul(out, a, b);
+  return out;
+}
+
+[[gnu::pure]] inline sc
+sc_sqr(const sc& a) noexcept
+{
+  sc out;
+  sc_sqr(out, a);
+  return out;
+}
+
+[[gnu::pure]] inline bool
+sc_is_zero(const sc& a) noexcept
+{
+  return (a.n[0] | a.n[1] | a.n[2] | a.n[3]) == 0;
+}
+
+[[gnu::pure]] inline sc
+sc_add(const sc& a, const sc& b) noexcept
+{
+  std::uint64_t r[4];
+  u128 carry = 0;
+  for (int i = 0; i != 4; ++i)
+  {
+    carry += (u128)a.n[i] + b.n[i];
+    r[i] = (std::uint64_t)carry;
+    carry >>= 64;
+  }
+
+  sc out;
+  detail::sc_cond_sub_n(out.n, r, (std::uint64_t)carry);
+  return out;
+}
+
+[[gnu::pure]] inline sc
+sc_neg(const sc& a) noexcept
+{
+  // n - a, and 0 stays 0
+  sc out;
+  std::uint64_t borrow = 0;
+  for (int i = 0; i != 4; ++i)
+  {
+    const u128 d = (u128)sc_n.n[i] - a.n[i] - borrow;
+    out.n[i]     = (std::uint64_t)d;
+    borrow       = (std::uint64_t)(d >> 64) & 1;
+  }
+
+  const std::uint64_t mask = 0 - (std::uint64_t)!sc_is_zero(a);
+  for (int i = 0; i != 4; ++i)
+  {
+    out.n[i] &= mask;
+  }
+  return out;
+}
+
+[[gnu::pure]] inline sc
+sc_sub(const sc& a, const sc& b) noexcept
+{
+  return sc_add(a, sc_neg(b));
+}
+
+/*
+  a^(n-2) with a fixed 4 bit window. the exponent is public so the sequence of squarings and
+  table lookups is the same for every input, constant time in a. 0 maps to 0
+*/
+[[gnu::pure]] inline sc
+sc_inv(const sc& a) noexcept
+{
+  // n - 2, most significant nibble first
+  static constexpr std::uint64_t e[4] = {0xBFD25E8CD036413Full, 0xBAAEDCE6AF48A03Bull, 0xFFFFFFFFFFFFFFFEull, 0xFFFFFFFFFFFFFFFFull};
+
+  sc table[16];
+  table[0] = sc_one;
+  table[1] = a;
+  for (int i = 2; i != 16; ++i)
+  {
+    sc_mul(table[i], table[i - 1], a);
+  }
+
+  sc r = table[e[3] >> 60];
+  for (int w = 62; w >= 0; --w)
+  {
+    sc_sqr(r, r);
+    sc_sqr(r, r);
+    sc_sqr(r, r);
+    sc_sqr(r, r);
+    sc_mul(r, r, table[(e[w / 16] >> ((w % 16) * 4)) & 0xf]);
+  }
+  return r;
+}
+
+/* montgomery's trick like fe_batch_inv, zeros are skipped and stay zero */
+inline void
+sc_batch_inv(std::span<sc> _v)
+{
+  std::vector<sc> scratch(_v.size());
+
+  sc acc = sc_one;
+  for (std::size_t i = 0; i != _v.size(); ++i)
+  {
+    scratch[i] = acc;
+    if (!sc_is_zero(_v[i])) [[likely]]
+    {
+      sc_mul(acc, acc, _v[i]);
+    }
+  }
+
+  sc inv = sc_inv(acc);
+  for (std::size_t i = _v.size(); i-- != 0;)
+  {
+    if (sc_is_zero(_v[i])) [[unlikely]]
+    {
+      continue;
+    }
+
+    const sc t = sc_mul(inv, scratch[i]);
+    sc_mul(inv, inv, _v[i]);
+    _v[i] = t;
+  }
+}
+
+/* upper half (> (n-1)/2), for low s normalization. s is public, not constant time */
+[[gnu::pure]] inline bool
+sc_is_high(const sc& a) noexcept
+{
+  static constexpr std::uint64_t half[4] = {0xDFE92F46681B20A0ull, 0x5D576E7357A4501Dull, 0xFFFFFFFFFFFFFFFFull, 0x7FFFFFFFFFFFFFFFull};
+
+  for (std::size_t i = 4; i-- != 0;)
+  {
+    if (a.n[i] != half[i])
+    {
+      return a.n[i] > half[i];
+    }
+  }
+  return false;
+}
+
+/* x mod n for a field element, x < p < 2n so one subtract does it */
+[[gnu::pure]] inline sc
+sc_from_fe(const fe& _x) noexcept
+{
+  sc out;
+  detail::sc_cond_sub_n(out.n, _x.n, 0);
+  return out;
+}
+
+/* the 4 bit window w (bits 4w .. 4w+3), the digit hook for windowed scalar muls */
+[[gnu::pure]] inline std::size_t
+sc_window(const sc& a, std::size_t w) noexcept
+{
+  return (a.n[w / 16] >> ((w % 16) * 4)) & 0xf;
+}
+
+/* _count (<= 32) bits starting at bit _start, may straddle limbs. for wider bucket windows */
+[[gnu::pure]] inline std::size_t
+sc_bits(const sc& a, std::size_t _start, std::size_t _count) noexcept
+{
+  if (_start >= 256)
+  {
+    return 0;
+  }
+
+  const std::size_t limb  = _start / 64;
+  const std::size_t shift = _start % 64;
+
+  std::uint64_t v = a.n[limb] >> shift;
+  if (shift + _count > 64 && limb != 3)
+  {
+    v |= a.n[limb + 1] << (64 - shift);
+  }
+  return v & ((std::uint64_t{1} << _count) - 1);
+}
+
+/* bit length, for skipping the leading zero windows of public scalars */
+[[gnu::pure]] inline std::size_t
+sc_bitlength(const sc& a) noexcept
+{
+  for (std::size_t i = 4; i-- != 0;)
+  {
+    if (a.n[i])
+    {
+      return 64 * i + 64 - __builtin_clzll(a.n[i]);
+    }
+  }
+  return 0;
+}
+
+inline void
+sc_to_bytes(const sc& _a, std::byte* _out) noexcept
+{
+  detail::store_be256(_a.n, _out);
+}
+
+/* 32 bytes big endian reduced mod n, returns false if they were >= n (still reduced into _out) */
+inline bool
+sc_from_bytes(sc& _out, const std::byte* _in) noexcept
+{
+  std::uint64_t r[4];
+  detail::load_be256(r, _in);
+
+  detail::sc_cond_sub_n(_out.n, r, 0);
+  return _out.n[0] == r[0] && _out.n[1] == r[1] && _out.n[2] == r[2] && _out.n[3] == r[3];
+}
+
+[[gnu::pure]] inline sc
+sc_from_ix(const GmpWrapper& _n)
+{
+  const GmpWrapper r = _n % GmpWrapper{"0xFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141"};
+  sc out;
+  r.to_limbs(out.n, 4);
+  return out;
+}
+
+[[gnu::pure]] inline GmpWrapper
+sc_to_ix(const sc& _n)
+{
+  return GmpWrapper::from_limbs(_n.n, 4);
+}
+
+} // namespace blue_crypto
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "curve_batch.h"
+#include "drbg.h"
+#include "msm.h"
+#include "scalar.h"
+#include "sha256.h"
+
+/*
+  BIP340 schnorr signatures over secp256k1, 32 byte messages.
+
+  public keys are x only: the point is always the one with even y (lift_x with the field
+  square root), a private key whose d*G has odd y signs as n - d. tagged hashes start from a
+  sha256 midstate with SHA256(tag) || SHA256(tag) already absorbed, so each one costs the
+  same as a plain hash of the data. verify is one double_base_mul and one fe_inv for the
+  parity of R, batch verify folds the whole batch into a single msm.
+*/
+
+namespace blue_crypto::secp256k1
+{
+
+struct schnorr_sig
+{
+  fe r;
+  sc s;
+
+  bool
+  operator==(const schnorr_sig& other) const
+  {
+    return (r == other.r) && (s == other.s);
+  }
+};
+
+/* x(R) || s, 32 bytes big endian each */
+inline void
+to_compact(const schnorr_sig& _sig, std::byte* _out) noexcept
+{
+  fe_to_bytes(_sig.r, _out);
+  sc_to_bytes(_sig.s, _out + 32);
+}
+
+/* false if r >= p or s >= n */
+inline bool
+from_compact(schnorr_sig& _sig, const std::byte* _in) noexcept
+{
+  const bool r_ok = fe_from_bytes(_sig.r, _in);
+  const bool s_ok = sc_from_bytes(_sig.s, _in + 32);
+  return r_ok && s_ok;
+}
+
+/* sha256 with SHA256(_tag) || SHA256(_tag) absorbed, copy it and feed the data */
+inline sha256
+tagged_sha256(std::string_view _tag) noexcept
+{
+  const auto t = sha256::hash(std::as_bytes(std::span{_tag.data(), _tag.size()}));
+
+  sha256 h;
+  h.update(t).update(t);
+  return h;
+}
+
+inline sha256_digest
+tagged_hash(std::string_view _tag, std::span<const std::byte> _data) noexcept
+{
+  return tagged_sha256(_tag).update(_data).finalize();
+}
+
+namespace detail
+{
+
+inline const sha256&
+bip340_aux() noexcept
+{
+  static const sha256 h = tagged_sha256("BIP0340/aux");
+  return h;
+}
+
+inline const sha256&
+bip340_nonce() noexcept
+{
+  static const sha256 h = tagged_sha256("BIP0340/nonce");
+  return h;
+}
+
+inline const sha256&
+bip340_challenge() noexcept
+{
+  static const sha256 h = tagged_sha256("BIP0340/challenge");
+  return h;
+}
+
+/* e = int(hash_challenge(r || x(P) || m)) mod n */
+inline sc
+bip340_e(const fe& _r, const fe& _px, const std::byte* _msg) noexcept
+{
+  std::byte buf[96];
+  fe_to_bytes(_r, buf);
+  fe_to_bytes(_px, buf + 32);
+  std::copy_n(_msg, 32, buf + 64);
+
+  const auto d = sha256{bip340_challenge()}.update(buf).finalize();
+
+  sc e;
+  sc_from_bytes(e, d.data());
+  return e;
+}
+
+} // namespace detail
+
+/* the point for a 32 byte x only key, false if x >= p or it isn't on the curve */
+inline bool
+xonly_from_bytes(crv_p& _pub, const std::byte* _in) noexcept
+{
+  fe x;
+  return fe_from_bytes(x, _in) && lift_x(_pub, x, false);
+}
+
+/* the x only public key of _priv (nonzero) as the even y point */
+inline crv_p
+xonly_pubkey(const sc& _priv)
+{
+  crv_p P = from_jacobian(fixed_base_mul(_priv));
+  if (P.y.n[0] & 1)
+  {
+    P.y = fe_neg(P.y);
+  }
+  return P;
+}
+
+/*
+  BIP340 default signing. _aux is 32 bytes of auxiliary randomness (all zero still gives a
+  valid, deterministic signature). the nonce point comes off the fixed base table like ecdsa,
+  two fe_inv for the affine P and R and no sc_inv at all. false (and _out untouched) for a zero
+  key or a nonce hash that is 0 mod n, where BIP340 fails instead of retrying
+*/
+inline bool
+schnorr_sign(schnorr_sig& _out, const sc& _priv, const std::byte* _msg, const std::byte* _aux)
+{
+  if (sc_is_zero(_priv))
+  {
+    return false;
+  }
+
+  const crv_p P = from_jacobian(fixed_base_mul(_priv));
+  const sc d    = (P.y.n[0] & 1) ? sc_neg(_priv) : _priv;
+
+  // t = bytes(d) xor hash_aux(a), rand = hash_nonce(t || x(P) || m)
+  std::byte buf[96];
+  const auto aux = sha256{detail::bip340_aux()}.update({_aux, 32}).finalize();
+  sc_to_bytes(d, buf);
+  for (std::size_t i = 0; i != 32; ++i)
+  {
+    buf[i] ^= aux[i];
+  }
+  fe_to_bytes(P.x, buf + 32);
+  std::copy_n(_msg, 32, buf + 64);
+
+  auto rand = sha256{detail::bip340_nonce()}.update(buf).finalize();
+
+  sc k;
+  sc_from_bytes(k, rand.data());
+  secure_wipe(buf, sizeof(buf));
+  secure_wipe(rand.data(), rand.size());
+
+  // signing with k = 0 would publish d, release builds included
+  if (sc_is_zero(k)) [[unlikely]]
+  {
+    return false;
+  }
+
+  const crv_p R = from_jacobian(fixed_base_mul(k));
+  if (R.y.n[0] & 1)
+  {
+    k = sc_neg(k);
+  }
+
+  _out = {R.x, sc_add(k, sc_mul(detail::bip340_e(R.x, P.x, _msg), d))};
+
+  secure_wipe(&k, sizeof(k));
+  return true;
+}
+
+/*
+  R = s G - e P through double_base_mul, then R must not be O, have even y and x(R) == r.
+  _pub is the even y point from xonly_from_bytes / xonly_pubkey
+*/
+inline bool
+schnorr_verify(const crv_p& _pub, const std::byte* _msg, const schnorr_sig& _sig)
+{
+  const sc e         = detail::bip340_e(_sig.r, _pub.x, _msg);
+  const jcbn_crv_p R = double_base_mul(_sig.s, _pub, sc_neg(e));
+
+  if (is_identity(R))
+  {
+    return false;
+  }
+
+  // x first, projectively, the inversion is only paid for the parity of y
+  if (fe_mul(_sig.r, fe_sqr(R.z)) != R.x)
+  {
+    return false;
+  }
+  const fe zi = fe_inv(R.z);
+  const fe y  = fe_mul(R.y, fe_mul(fe_sqr(zi), zi));
+  return (y.n[0] & 1) == 0;
+}
+
+/* below this many signatures the bisection just verifies one by one */
+static constexpr std::size_t schnorr_batch_leaf = 4;
+
+/*
+  BIP340 batch verification: with a_0 = 1 and random 128 bit a_i
+      (sum a_i s_i) G - sum a_i R_i - sum (a_i e_i) P_i = O
+  as one msm over 2n + 1 points, R_i = lift_x(r_i) with even y. unlike ecdsa there are no
+  hints and no inversions mod n needed, the r values are the x coordinates already. if the
+  sum isn't O the range is split like ecdsa_verify_batch to find the bad ones.
+  _valid gets 1 / 0 per signature, returns true if all of them passed.
+*/
+inline bool
+schnorr_verify_batch(std::span<const crv_p> _pubs, std::span<const sha256_digest> _msgs, std::span<const schnorr_sig> _sigs,
+                     std::span<std::uint8_t> _valid)
+{
+  const std::size_t n = _sigs.size();
+  assert(_pubs.size() == n && _msgs.size() == n && _valid.size() == n);
+
+  std::vector<sc> e(n), a(n);
+  std::vector<crv_p> R(n);
+  std::vector<std::uint8_t> usable(n);
+
+  chacha_drbg& rng = chacha_drbg::local();
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    e[i]      = detail::bip340_e(_sigs[i].r, _pubs[i].x, _msgs[i].data());
+    usable[i] = lift_x(R[i], _sigs[i].r, false);
+
+    do
+    {
+      a[i] = {{rng.next_u64(), rng.next_u64(), 0, 0}};
+    } while (sc_is_zero(a[i]));
+  }
+  if (n != 0)
+  {
+    a[0] = sc_one;
+  }
+
+  std::vector<crv_p> points;
+  std::vector<sc> scalars;
+
+  const auto batch_ok = [&](std::size_t _lo, std::size_t _hi)
+  {
+    points.clear();
+    scalars.clear();
+
+    sc g = sc_zero;
+    for (std::size_t i = _lo; i != _hi; ++i)
+    {
+      if (!usable[i])
+      {
+        return false;
+      }
+
+      g = sc_add(g, sc_mul(a[i], _sigs[i].s));
+      points.push_back(_pubs[i]);
+      scalars.push_back(sc_neg(sc_mul(a[i], e[i])));
+      points.push_back(R[i]);
+      scalars.push_back(sc_neg(a[i]));
+    }
+    points.push_back(G);
+    scalars.push_back(g);
+
+    return is_identity(msm(points, scalars));
+  };
+
+  const auto check = [&](const auto& _self, std::size_t _lo, std::size_t _hi) -> void
+  {
+    if (_hi - _lo <= schnorr_batch_leaf)
+    {
+      for (std::size_t i = _lo; i != _hi; ++i)
+      {
+        _valid[i] = schnorr_verify(_pubs[i], _msgs[i].data(), _sigs[i]);
+      }
+      return;
+    }
+
+    if (batch_ok(_lo, _hi))
+    {
+      std::fill(_valid.begin() + _lo, _valid.begin() + _hi, 1);
+      return;
+    }
+
+    const std::size_t mid = _lo + (_hi - _lo) / 2;
+    _self(_self, _lo, mid);
+    _self(_self, mid, _hi);
+  };
+
+  check(check, 0, n);
+  return std::all_of(_valid.begin(), _valid.end(), [](std::uint8_t v) { return v != 0; });
+}
+
+} // namespace blue_crypto::secp256k1
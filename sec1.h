@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "curve.h"
+#include "curve_simd.h"
+
+/*
+  SEC1 (section 2.3.3 / 2.3.4) point encoding, straight between byte spans and crv_p without
+  going through GmpWrapper:
+
+    compressed   : 0x02 / 0x03 (parity of y) || x               33 bytes
+    uncompressed : 0x04 || x || y                                65 bytes
+
+  decompression is lift_x (one fe_sqrt). the bulk decoder gathers all the x^3 + 7 first and
+  takes their roots through fe_sqrt_many. the point at infinity (the single 0x00 byte) and the
+  hybrid 0x06 / 0x07 forms are not accepted.
+*/
+
+namespace blue_crypto::secp256k1
+{
+
+static constexpr std::size_t sec1_compressed_size   = 33;
+static constexpr std::size_t sec1_uncompressed_size = 65;
+
+/* 0x04 || x || y, _p must not be O */
+inline void
+to_uncompressed(const crv_p& _p, std::byte* _out) noexcept
+{
+  _out[0] = std::byte{0x04};
+  fe_to_bytes(_p.x, _out + 1);
+  fe_to_bytes(_p.y, _out + 33);
+}
+
+/* compressed if _out is 33 bytes, uncompressed if it is 65. false for any other size or O */
+inline bool
+sec1_encode(const crv_p& _p, std::span<std::byte> _out) noexcept
+{
+  if (_p == a_identity_element)
+  {
+    return false;
+  }
+
+  switch (_out.size())
+  {
+  case sec1_compressed_size:
+    to_compressed(_p, _out.data());
+    return true;
+  case sec1_uncompressed_size:
+    to_uncompressed(_p, _out.data());
+    return true;
+  default:
+    return false;
+  }
+}
+
+/* false (and _p untouched) for a bad prefix / length, a coordinate >= p or a point not on the curve */
+inline bool
+sec1_decode(crv_p& _p, std::span<const std::byte> _in) noexcept
+{
+  fe x, y;
+
+  if (_in.size() == sec1_compressed_size && (_in[0] == std::byte{0x02} || _in[0] == std::byte{0x03}))
+  {
+    crv_p out;
+    if (!fe_from_bytes(x, _in.data() + 1) || !lift_x(out, x, _in[0] == std::byte{0x03}))
+    {
+      return false;
+    }
+    _p = out;
+    return true;
+  }
+
+  if (_in.size() == sec1_uncompressed_size && _in[0] == std::byte{0x04})
+  {
+    if (!fe_from_bytes(x, _in.data() + 1) || !fe_from_bytes(y, _in.data() + 33) ||
+        fe_sqr(y) != fe_add(fe_mul(fe_sqr(x), x), curve_b))
+    {
+      return false;
+    }
+    _p = {x, y};
+    return true;
+  }
+
+  return false;
+}
+
+/*
+  _in holds _out.size() encodings back to back, all 33 or all 65 bytes (the stride is
+  _in.size() / _out.size()). the square roots of a compressed batch go through fe_sqrt_many
+  together. _valid gets 1 / 0 per point (a failed one is left at O), returns true if all decoded
+*/
+inline bool
+sec1_decode_many(std::span<const std::byte> _in, std::span<crv_p> _out, std::span<std::uint8_t> _valid)
+{
+  const std::size_t n = _out.size();
+  assert(_valid.size() == n);
+
+  if (n == 0)
+  {
+    return true;
+  }
+
+  const std::size_t stride = _in.size() / n;
+  assert(_in.size() == n * stride);
+
+  if (stride != sec1_compressed_size)
+  {
+    bool all = true;
+    for (std::size_t i = 0; i != n; ++i)
+    {
+      _out[i]   = a_identity_element;
+      _valid[i] = sec1_decode(_out[i], _in.subspan(i * stride, stride));
+      all &= _valid[i] != 0;
+    }
+    return all;
+  }
+
+  // x^3 + 7 for every well formed entry, 0 (which has a root) as a placeholder for the rest
+  std::vector<fe> rhs(n, fe_zero);
+  std::vector<std::uint8_t> parsed(n);
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    const std::byte* e = &_in[i * stride];
+
+    _out[i]   = a_identity_element;
+    parsed[i] = (e[0] == std::byte{0x02} || e[0] == std::byte{0x03}) && fe_from_bytes(_out[i].x, e + 1);
+    if (parsed[i])
+    {
+      rhs[i] = fe_add(fe_mul(fe_sqr(_out[i].x), _out[i].x), curve_b);
+    }
+  }
+
+  fe_sqrt_many(rhs, rhs, _valid);
+
+  bool all = true;
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    _valid[i] &= parsed[i];
+    if (!_valid[i])
+    {
+      _out[i] = a_identity_element;
+      all     = false;
+      continue;
+    }
+
+    const bool odd = _in[i * stride] == std::byte{0x03};
+    _out[i].y      = ((rhs[i].n[0] & 1) != odd) ? fe_neg(rhs[i]) : rhs[i];
+  }
+  return all;
+}
+
+} // namespace blue_crypto::secp256k1
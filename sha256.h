@@ -0,0 +1,372 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "rng.h"
+
+/*
+  SHA-256 (FIPS 180-4), HMAC-SHA256 (RFC 2104) and HKDF-SHA256 (RFC 5869), used for message
+  hashes, the RFC 6979 nonces and deriving keys from ECDH secrets. streaming interface, the
+  compression function is the SHA-NI one where the cpu has it and plain portable C++ otherwise.
+*/
+
+namespace blue_crypto
+{
+
+using sha256_digest = std::array<std::byte, 32>;
+
+namespace detail
+{
+
+static constexpr std::uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be,
+    0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa,
+    0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85,
+    0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
+    0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static constexpr std::uint32_t sha256_iv[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                               0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+inline std::uint32_t
+load_be32(const std::byte* _p) noexcept
+{
+  std::uint32_t v;
+  std::memcpy(&v, _p, 4);
+  return __builtin_bswap32(v);
+}
+
+inline void
+store_be32(std::byte* _p, std::uint32_t _v) noexcept
+{
+  _v = __builtin_bswap32(_v);
+  std::memcpy(_p, &_v, 4);
+}
+
+inline void
+sha256_compress_portable(std::uint32_t* _state, const std::byte* _blocks, std::size_t _n) noexcept
+{
+  const auto rotr = [](std::uint32_t x, int r) { return (x >> r) | (x << (32 - r)); };
+
+  for (; _n != 0; --_n, _blocks += 64)
+  {
+    std::uint32_t w[64];
+    for (int i = 0; i != 16; ++i)
+    {
+      w[i] = load_be32(_blocks + 4 * i);
+    }
+    for (int i = 16; i != 64; ++i)
+    {
+      const std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+      const std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+      w[i]                   = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    std::uint32_t a = _state[0], b = _state[1], c = _state[2], d = _state[3];
+    std::uint32_t e = _state[4], f = _state[5], g = _state[6], h = _state[7];
+
+    for (int i = 0; i != 64; ++i)
+    {
+      const std::uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+      const std::uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+
+    _state[0] += a;
+    _state[1] += b;
+    _state[2] += c;
+    _state[3] += d;
+    _state[4] += e;
+    _state[5] += f;
+    _state[6] += g;
+    _state[7] += h;
+  }
+}
+
+#if defined(__x86_64__)
+
+/*
+  two rounds per sha256rnds2, the state lives as ABEF / CDGH. the message schedule for w[t..t+3]
+  is msg2(msg1(w[t-16..], w[t-12..]) + w[t-7..t-4], w[t-4..]), kept in a rolling set of 4 registers
+*/
+[[gnu::target("sha,sse4.1")]] inline void
+sha256_compress_shani(std::uint32_t* _state, const std::byte* _blocks, std::size_t _n) noexcept
+{
+  const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bll, 0x0405060700010203ll);
+
+  // ABCD / EFGH -> ABEF / CDGH
+  const __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&_state[0]), 0xB1);
+  const __m128i efgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&_state[4]), 0x1B);
+  __m128i s0         = _mm_alignr_epi8(abcd, efgh, 8);
+  __m128i s1         = _mm_blend_epi16(efgh, abcd, 0xF0);
+
+  for (; _n != 0; --_n, _blocks += 64)
+  {
+    const __m128i s0_in = s0;
+    const __m128i s1_in = s1;
+
+    __m128i m[4];
+    for (int j = 0; j != 4; ++j)
+    {
+      m[j] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(_blocks + 16 * j)), bswap);
+    }
+
+#pragma GCC unroll 16
+    for (int j = 0; j != 16; ++j)
+    {
+      if (j >= 4)
+      {
+        const __m128i t = _mm_add_epi32(_mm_sha256msg1_epu32(m[j % 4], m[(j + 1) % 4]), _mm_alignr_epi8(m[(j + 3) % 4], m[(j + 2) % 4], 4));
+        m[j % 4]        = _mm_sha256msg2_epu32(t, m[(j + 3) % 4]);
+      }
+
+      const __m128i wk = _mm_add_epi32(m[j % 4], _mm_loadu_si128((const __m128i*)&sha256_k[4 * j]));
+      s1               = _mm_sha256rnds2_epu32(s1, s0, wk);
+      s0               = _mm_sha256rnds2_epu32(s0, s1, _mm_shuffle_epi32(wk, 0x0E));
+    }
+
+    s0 = _mm_add_epi32(s0, s0_in);
+    s1 = _mm_add_epi32(s1, s1_in);
+  }
+
+  // back to ABCD / EFGH
+  const __m128i feba = _mm_shuffle_epi32(s0, 0x1B);
+  const __m128i dchg = _mm_shuffle_epi32(s1, 0xB1);
+  _mm_storeu_si128((__m128i*)&_state[0], _mm_blend_epi16(feba, dchg, 0xF0));
+  _mm_storeu_si128((__m128i*)&_state[4], _mm_alignr_epi8(dchg, feba, 8));
+}
+
+#endif
+
+struct sha256_kernels
+{
+  bool shani;
+  const char* name;
+};
+
+inline sha256_kernels
+select_sha256_kernels() noexcept
+{
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1"))
+  {
+    return {true, "sha-ni"};
+  }
+#endif
+  return {false, "portable"};
+}
+
+} // namespace detail
+
+/* resolved once during static init, like fe_kernel */
+inline const detail::sha256_kernels sha256_kernel = detail::select_sha256_kernels();
+
+namespace detail
+{
+
+inline void
+sha256_compress(std::uint32_t* _state, const std::byte* _blocks, std::size_t _n) noexcept
+{
+#if defined(__x86_64__)
+  if (sha256_kernel.shani) [[likely]]
+  {
+    return sha256_compress_shani(_state, _blocks, _n);
+  }
+#endif
+  sha256_compress_portable(_state, _blocks, _n);
+}
+
+} // namespace detail
+
+class sha256
+{
+public:
+  sha256() { std::memcpy(state_, detail::sha256_iv, sizeof(state_)); }
+
+  sha256&
+  update(std::span<const std::byte> _data) noexcept
+  {
+    total_ += _data.size();
+
+    if (fill_ != 0)
+    {
+      const std::size_t n = std::min(_data.size(), buf_.size() - fill_);
+      std::copy_n(_data.begin(), n, buf_.begin() + fill_);
+      fill_ += n;
+      _data = _data.subspan(n);
+
+      if (fill_ != buf_.size())
+      {
+        return *this;
+      }
+      detail::sha256_compress(state_, buf_.data(), 1);
+      fill_ = 0;
+    }
+
+    const std::size_t blocks = _data.size() / 64;
+    if (blocks != 0)
+    {
+      detail::sha256_compress(state_, _data.data(), blocks);
+      _data = _data.subspan(blocks * 64);
+    }
+
+    std::copy(_data.begin(), _data.end(), buf_.begin());
+    fill_ = _data.size();
+    return *this;
+  }
+
+  sha256_digest
+  finalize() noexcept
+  {
+    const std::uint64_t bits = total_ * 8;
+
+    std::byte pad[72]{};
+    pad[0]                = std::byte{0x80};
+    const std::size_t len = (fill_ < 56 ? 56 : 120) - fill_;
+    for (int i = 0; i != 8; ++i)
+    {
+      pad[len + i] = std::byte(bits >> (56 - 8 * i));
+    }
+    update({pad, len + 8});
+
+    sha256_digest out;
+    for (int i = 0; i != 8; ++i)
+    {
+      detail::store_be32(out.data() + 4 * i, state_[i]);
+    }
+    return out;
+  }
+
+  static sha256_digest
+  hash(std::span<const std::byte> _data) noexcept
+  {
+    return sha256{}.update(_data).finalize();
+  }
+
+private:
+  std::uint32_t state_[8];
+  std::array<std::byte, 64> buf_{};
+  std::size_t fill_    = 0;
+  std::uint64_t total_ = 0;
+};
+
+class hmac_sha256
+{
+public:
+  explicit hmac_sha256(std::span<const std::byte> _key) noexcept
+  {
+    std::array<std::byte, 64> k{};
+    if (_key.size() > k.size())
+    {
+      const auto d = sha256::hash(_key);
+      std::memcpy(k.data(), d.data(), d.size());
+    }
+    else
+    {
+      std::copy(_key.begin(), _key.end(), k.begin());
+    }
+
+    std::array<std::byte, 64> pad;
+    for (std::size_t i = 0; i != 64; ++i)
+    {
+      pad[i] = k[i] ^ std::byte{0x36};
+    }
+    inner_.update(pad);
+
+    for (std::size_t i = 0; i != 64; ++i)
+    {
+      pad[i] = k[i] ^ std::byte{0x5c};
+    }
+    outer_.update(pad);
+
+    // k is the mac key (rfc 6979 K, the hkdf prk), neither copy stays on the stack
+    secure_wipe(k.data(), k.size());
+    secure_wipe(pad.data(), pad.size());
+  }
+
+  hmac_sha256&
+  update(std::span<const std::byte> _data) noexcept
+  {
+    inner_.update(_data);
+    return *this;
+  }
+
+  sha256_digest
+  finalize() noexcept
+  {
+    const auto inner = inner_.finalize();
+    return outer_.update(inner).finalize();
+  }
+
+  static sha256_digest
+  mac(std::span<const std::byte> _key, std::span<const std::byte> _data) noexcept
+  {
+    return hmac_sha256{_key}.update(_data).finalize();
+  }
+
+private:
+  sha256 inner_, outer_;
+};
+
+/* HKDF-Extract, an empty salt is the same as 32 zero bytes (both pad to the same HMAC key) */
+inline sha256_digest
+hkdf_extract(std::span<const std::byte> _salt, std::span<const std::byte> _ikm) noexcept
+{
+  return hmac_sha256::mac(_salt, _ikm);
+}
+
+/* HKDF-Expand into all of _out (at most 255 * 32 bytes), the keyed HMAC state is set up once */
+inline void
+hkdf_expand(const sha256_digest& _prk, std::span<const std::byte> _info, std::span<std::byte> _out) noexcept
+{
+  assert(_out.size() <= 255 * 32);
+
+  const hmac_sha256 keyed{_prk};
+
+  sha256_digest t;
+  std::size_t t_len = 0;
+  for (std::uint8_t i = 1; !_out.empty(); ++i)
+  {
+    const std::byte counter{i};
+    t = hmac_sha256{keyed}.update({t.data(), t_len}).update(_info).update({&counter, 1}).finalize();
+
+    const std::size_t n = std::min(_out.size(), t.size());
+    std::memcpy(_out.data(), t.data(), n);
+    _out  = _out.subspan(n);
+    t_len = t.size();
+  }
+
+  secure_wipe(t.data(), t.size());
+}
+
+/* extract then expand, the pseudo random key never leaves this function */
+inline void
+hkdf_sha256(std::span<std::byte> _out, std::span<const std::byte> _ikm, std::span<const std::byte> _salt = {},
+            std::span<const std::byte> _info = {}) noexcept
+{
+  sha256_digest prk = hkdf_extract(_salt, _ikm);
+  hkdf_expand(prk, _info, _out);
+  secure_wipe(prk.data(), prk.size());
+}
+
+} // namespace blue_crypto
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "sha256.h"
+
+/*
+  multi buffer SHA-256: W equal length messages hashed together, lane l of every 32 bit
+  vector belongs to message l. 8 lanes with avx2, 16 with avx512f. the round function is
+  written once over gcc vector types and instantiated inside the target specific entry points
+  (always_inline, so it is compiled for the caller's isa; the rotates are spelled out for the
+  same reason, no vector is ever passed through the default abi). the message words are transposed
+  into lane order with plain loads, a 32 byte secret is a single block so that is cheap next
+  to the 64 rounds.
+*/
+
+namespace blue_crypto
+{
+
+namespace detail
+{
+
+// spelled out per width, gcc doesn't treat a vector_size with a dependent argument as a vector in templates
+template <std::size_t W>
+struct sha256_vec;
+
+template <>
+struct sha256_vec<8>
+{
+  using type = std::uint32_t __attribute__((vector_size(32)));
+};
+
+template <>
+struct sha256_vec<16>
+{
+  using type = std::uint32_t __attribute__((vector_size(64)));
+};
+
+/* the bytes of block _b of a _len byte message with the sha256 padding, as big endian words */
+inline void
+sha256_padded_words(std::uint32_t* _w, const std::byte* _msg, std::size_t _len, std::size_t _b) noexcept
+{
+  const std::size_t base = 64 * _b;
+  if (base + 64 <= _len) [[likely]]
+  {
+    for (std::size_t j = 0; j != 16; ++j)
+    {
+      _w[j] = load_be32(_msg + base + 4 * j);
+    }
+    return;
+  }
+
+  // message tail, the 0x80 marker and (in the last block) the bit length
+  std::byte block[64] = {};
+  if (base < _len)
+  {
+    std::memcpy(block, _msg + base, _len - base);
+  }
+  if (base <= _len)
+  {
+    block[_len - base] = std::byte{0x80};
+  }
+  if (64 * (_b + 1) == (_len + 9 + 63) / 64 * 64)
+  {
+    const std::uint64_t bits = std::uint64_t{_len} * 8;
+    store_be32(block + 56, static_cast<std::uint32_t>(bits >> 32));
+    store_be32(block + 60, static_cast<std::uint32_t>(bits));
+  }
+  for (std::size_t j = 0; j != 16; ++j)
+  {
+    _w[j] = load_be32(block + 4 * j);
+  }
+}
+
+template <std::size_t W>
+[[gnu::always_inline]] inline void
+sha256_many_lanes(const std::byte* const* _msgs, std::size_t _len, sha256_digest* _out) noexcept
+{
+  using V = typename sha256_vec<W>::type;
+
+  V s[8];
+  for (std::size_t i = 0; i != 8; ++i)
+  {
+    s[i] = V{} + sha256_iv[i];
+  }
+
+  const std::size_t blocks = (_len + 9 + 63) / 64;
+  for (std::size_t b = 0; b != blocks; ++b)
+  {
+    alignas(64) std::uint32_t words[W][16];
+    for (std::size_t l = 0; l != W; ++l)
+    {
+      sha256_padded_words(words[l], _msgs[l], _len, b);
+    }
+
+    V w[16];
+    for (std::size_t j = 0; j != 16; ++j)
+    {
+      for (std::size_t l = 0; l != W; ++l)
+      {
+        w[j][l] = words[l][j];
+      }
+    }
+
+    V a = s[0], bb = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+
+    for (std::size_t i = 0; i != 64; ++i)
+    {
+      if (i >= 16)
+      {
+        const V w15 = w[(i - 15) % 16], w2 = w[(i - 2) % 16];
+        const V s0  = (w15 >> 7 | w15 << 25) ^ (w15 >> 18 | w15 << 14) ^ (w15 >> 3);
+        const V s1  = (w2 >> 17 | w2 << 15) ^ (w2 >> 19 | w2 << 13) ^ (w2 >> 10);
+        w[i % 16] += s0 + w[(i - 7) % 16] + s1;
+      }
+
+      const V t1 = h + ((e >> 6 | e << 26) ^ (e >> 11 | e << 21) ^ (e >> 25 | e << 7)) + ((e & f) ^ (~e & g)) + sha256_k[i] + w[i % 16];
+      const V t2 = ((a >> 2 | a << 30) ^ (a >> 13 | a << 19) ^ (a >> 22 | a << 10)) + ((a & bb) ^ (a & c) ^ (bb & c));
+
+      h  = g;
+      g  = f;
+      f  = e;
+      e  = d + t1;
+      d  = c;
+      c  = bb;
+      bb = a;
+      a  = t1 + t2;
+    }
+
+    s[0] += a;
+    s[1] += bb;
+    s[2] += c;
+    s[3] += d;
+    s[4] += e;
+    s[5] += f;
+    s[6] += g;
+    s[7] += h;
+  }
+
+  for (std::size_t l = 0; l != W; ++l)
+  {
+    for (std::size_t i = 0; i != 8; ++i)
+    {
+      store_be32(_out[l].data() + 4 * i, s[i][l]);
+    }
+  }
+}
+
+#if defined(__x86_64__)
+
+[[gnu::target("avx2")]] inline void
+sha256_many_avx2(const std::byte* const* _msgs, std::size_t _len, sha256_digest* _out) noexcept
+{
+  sha256_many_lanes<8>(_msgs, _len, _out);
+}
+
+[[gnu::target("avx512f")]] inline void
+sha256_many_avx512(const std::byte* const* _msgs, std::size_t _len, sha256_digest* _out) noexcept
+{
+  sha256_many_lanes<16>(_msgs, _len, _out);
+}
+
+#endif
+
+struct sha256_mb_kernels
+{
+  std::size_t width;
+  const char* name;
+};
+
+inline sha256_mb_kernels
+select_sha256_mb_kernels() noexcept
+{
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+  {
+    return {16, "avx512 16 lanes"};
+  }
+  if (__builtin_cpu_supports("avx2"))
+  {
+    return {8, "avx2 8 lanes"};
+  }
+#endif
+  return {1, "single buffer"};
+}
+
+} // namespace detail
+
+/* resolved once during static init, like fe_kernel */
+inline const detail::sha256_mb_kernels sha256_mb_kernel = detail::select_sha256_mb_kernels();
+
+/*
+  _out.size() messages of _len bytes each, back to back in _msgs. full groups of lanes go
+  through the multi buffer kernel, the remainder through sha256::hash
+*/
+inline void
+sha256_many(std::span<const std::byte> _msgs, std::size_t _len, std::span<sha256_digest> _out) noexcept
+{
+  assert(_msgs.size() == _out.size() * _len);
+
+  const std::size_t width = sha256_mb_kernel.width;
+
+  std::size_t i = 0;
+#if defined(__x86_64__)
+  if (width != 1)
+  {
+    const std::byte* ptrs[16];
+    for (; i + width <= _out.size(); i += width)
+    {
+      for (std::size_t l = 0; l != width; ++l)
+      {
+        ptrs[l] = _msgs.data() + (i + l) * _len;
+      }
+
+      if (width == 16)
+      {
+        detail::sha256_many_avx512(ptrs, _len, &_out[i]);
+      }
+      else
+      {
+        detail::sha256_many_avx2(ptrs, _len, &_out[i]);
+      }
+    }
+  }
+#endif
+  for (; i != _out.size(); ++i)
+  {
+    _out[i] = sha256::hash(_msgs.subspan(i * _len, _len));
+  }
+}
+
+} // namespace blue_crypto
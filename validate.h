@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "curve.h"
+#include "curve_simd.h"
+#include "sec1.h"
+
+/*
+  batched peer key validation. a point passes if both coordinates are below p, it isn't O
+  and y^2 == x^3 + 7. the range checks are plain limb compares; the curve equation is two
+  squarings and a multiply per key, which go 8 keys at a time through ifma (avx2 loses to
+  mulx here, same as fe_sqrt_many). results come back as a bitmap, bit i % 64 of word i / 64,
+  so the ECDH side can drop the bad keys of a batch in one pass.
+*/
+
+namespace blue_crypto::secp256k1
+{
+
+[[gnu::const]] constexpr std::size_t
+bitmap_words(std::size_t _n) noexcept
+{
+  return (_n + 63) / 64;
+}
+
+[[gnu::pure]] inline bool
+bitmap_test(std::span<const std::uint64_t> _bitmap, std::size_t _i) noexcept
+{
+  return (_bitmap[_i / 64] >> (_i % 64)) & 1;
+}
+
+namespace detail
+{
+
+/* the limbs as they are, without any reduction, are < p */
+[[gnu::pure]] inline bool
+fe_is_canonical(const fe& _a) noexcept
+{
+  for (std::size_t i = 4; i-- != 0;)
+  {
+    if (_a.n[i] != fe_p.n[i])
+    {
+      return _a.n[i] < fe_p.n[i];
+    }
+  }
+  return false;
+}
+
+[[gnu::pure]] inline bool
+on_curve(const crv_p& _p) noexcept
+{
+  return fe_sqr(_p.y) == fe_add(fe_mul(fe_sqr(_p.x), _p.x), curve_b);
+}
+
+/* on_curve for B::width points per step, the tail is padded with G */
+template <class B>
+inline void
+on_curve_many(std::span<const crv_p> _pts, std::span<std::uint8_t> _ok) noexcept
+{
+  using elem = typename B::elem;
+
+  fe bs[B::width];
+  std::fill_n(bs, B::width, curve_b);
+  elem b;
+  B::load(b, bs);
+
+  for (std::size_t base = 0; base < _pts.size(); base += B::width)
+  {
+    const std::size_t n = std::min(B::width, _pts.size() - base);
+
+    fe xs[B::width], ys[B::width];
+    for (std::size_t l = 0; l != B::width; ++l)
+    {
+      const crv_p& p = l < n ? _pts[base + l] : G;
+      xs[l]          = p.x;
+      ys[l]          = p.y;
+    }
+
+    elem x, y, y2, x2, x3, d;
+    B::load(x, xs);
+    B::load(y, ys);
+    B::sqr(y2, y);
+    B::sqr(x2, x);
+    B::mul(x3, x2, x);
+    B::add(x3, x3, b);
+    B::sub(d, y2, x3);
+
+    for (std::size_t l = 0; l != n; ++l)
+    {
+      _ok[base + l] = fe_is_zero(B::get(d, l));
+    }
+  }
+}
+
+} // namespace detail
+
+/*
+  bit i of _bitmap (bitmap_words(_pts.size()) words) is set if _pts[i] is a valid public
+  key, unused bits of the last word are cleared. returns the number of valid keys
+*/
+inline std::size_t
+validate_points(std::span<const crv_p> _pts, std::span<std::uint64_t> _bitmap)
+{
+  assert(_bitmap.size() == bitmap_words(_pts.size()));
+
+  std::vector<std::uint8_t> ok(_pts.size());
+  if (lane_kernel == lane_backend::ifma)
+  {
+    detail::on_curve_many<lanes_ifma>(_pts, ok);
+  }
+  else if (!fe_kernel.adx && lane_kernel == lane_backend::avx2)
+  {
+    detail::on_curve_many<lanes_avx2>(_pts, ok);
+  }
+  else
+  {
+    for (std::size_t i = 0; i != _pts.size(); ++i)
+    {
+      ok[i] = detail::on_curve(_pts[i]);
+    }
+  }
+
+  std::fill(_bitmap.begin(), _bitmap.end(), 0);
+  std::size_t count = 0;
+  for (std::size_t i = 0; i != _pts.size(); ++i)
+  {
+    // O is (0, 0) here, which is off the curve anyway, the explicit check is for clarity
+    const bool valid = ok[i] && detail::fe_is_canonical(_pts[i].x) && detail::fe_is_canonical(_pts[i].y) && _pts[i] != a_identity_element;
+
+    _bitmap[i / 64] |= std::uint64_t{valid} << (i % 64);
+    count += valid;
+  }
+  return count;
+}
+
+/*
+  serialized keys (all 33 or all 65 bytes, see sec1_decode_many) decoded into _out and
+  checked. decoding already implies range and curve checks, this just packs the result
+*/
+inline std::size_t
+validate_sec1(std::span<const std::byte> _in, std::span<crv_p> _out, std::span<std::uint64_t> _bitmap)
+{
+  assert(_bitmap.size() == bitmap_words(_out.size()));
+
+  std::vector<std::uint8_t> ok(_out.size());
+  sec1_decode_many(_in, _out, ok);
+
+  std::fill(_bitmap.begin(), _bitmap.end(), 0);
+  for (std::size_t i = 0; i != _out.size(); ++i)
+  {
+    _bitmap[i / 64] |= std::uint64_t{ok[i]} << (i % 64);
+  }
+
+  std::size_t count = 0;
+  for (const std::uint64_t w : _bitmap)
+  {
+    count += std::popcount(w);
+  }
+  return count;
+}
+
+} // namespace blue_crypto::secp256k1